@@ -0,0 +1,226 @@
+/*******************************************************************************
+ Title          : id_sequence_check.cpp
+
+ Description    : Checks id_sequence against a vector holding the same IDs.
+                    Makes random inserts, erases, erase_alls, batch inserts and
+                    erases and assigns, on a few sequences that share leaves
+                    and nodes through copies, doing the same to a vector for
+                    each. After every change, size, count and a random
+                    position are compared, and every few changes the whole
+                    sequence is read back and compared. Stops with an error
+                    at the first difference.
+
+ Usage          : ./id_sequence_check [seed] [steps]
+                (seed picks the random changes, 1 if not given. steps is how
+                    many changes are made, 200000 if not given.)
+
+ Build with     : g++ -O1 -g -std=c++17 -fsanitize=address,undefined
+                    -o id_sequence_check bench/id_sequence_check.cpp
+                    id_sequence.cpp -I.
+
+ *******************************************************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "id_sequence.h"
+
+using namespace std;
+
+// Number of sequences changed, some of them copies of others
+const int SEQUENCES = 4;
+
+// Every how many changes whole sequences are compared
+const long FULL_CHECK_EVERY = 97;
+
+// Longest a sequence is allowed to grow before it is mostly erased
+const size_t LONGEST = 20000;
+
+// Number of IDs inserted at once at one position, enough to split one leaf
+// more times than there are labels between it and the next
+const size_t BURST = 6000;
+
+/* Stops with an error naming the step and what was different */
+void fail(long step, int s, const string &what) {
+    cerr << "ERROR: Step " << step << ", sequence " << s << ": " << what << "\n" << endl;
+    exit(-1);
+}
+
+/* Compares size, count of id and ID at a random position */
+void quick_check(long step, int s, const id_sequence &seq, const vector<uint32_t> &model, uint32_t id, mt19937 &random) {
+
+    if (seq.size() != model.size()) {
+        fail(step, s, "size is " + to_string(seq.size()) + " but should be " + to_string(model.size()));
+    }
+    size_t copies = count(model.begin(), model.end(), id);
+    if (seq.count(id) != copies) {
+        fail(step, s, "count of " + to_string(id) + " is " + to_string(seq.count(id)) + " but should be " + to_string(copies));
+    }
+    if (!model.empty()) {
+        size_t pos = random() % model.size();
+        if (seq.at(pos) != model[pos]) {
+            fail(step, s, "ID at " + to_string(pos) + " is " + to_string(seq.at(pos)) + " but should be " + to_string(model[pos]));
+        }
+    }
+}
+
+/* Reads whole sequence back, both by run and by position */
+void full_check(long step, int s, const id_sequence &seq, const vector<uint32_t> &model) {
+
+    vector<uint32_t> runs;
+    seq.for_each_run([&](const uint32_t *run, size_t n) {
+        runs.insert(runs.end(), run, run + n);
+    });
+    if (runs != model) {
+        fail(step, s, "IDs read by run are not the IDs added");
+    }
+    for (size_t pos=0; pos<model.size(); pos++) {
+        if (seq.at(pos) != model[pos]) {
+            fail(step, s, "ID at " + to_string(pos) + " is " + to_string(seq.at(pos)) + " but should be " + to_string(model[pos]));
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 1;
+    long steps = argc > 2 ? atol(argv[2]) : 200000;
+    mt19937 random(seed);
+
+    vector<id_sequence> seqs(SEQUENCES);
+    vector<vector<uint32_t> > models(SEQUENCES);
+
+    for (long step=0; step<steps; step++) {
+
+        int s = random() % SEQUENCES;
+        id_sequence &seq = seqs[s];
+        vector<uint32_t> &model = models[s];
+
+        // Few distinct IDs, so IDs are often repeated and spread over leaves
+        uint32_t range = step % 3 == 0 ? 16 : 1000;
+        uint32_t id = random() % range;
+        int change = random() % 100;
+
+        if (model.size() > LONGEST) {
+            change = 90;
+        }
+
+        // Insert many IDs one at a time at the same position, so the same
+        // leaf keeps splitting until there is no label left between it and
+        // the next and leaves have to be labelled again
+        if (change < 2) {
+            size_t pos = random() % (model.size() + 1);
+            for (size_t i=0; i<BURST; i++) {
+                seq.insert(pos, id);
+            }
+            model.insert(model.begin() + pos, BURST, id);
+        }
+
+        // Insert one ID
+        else if (change < 40) {
+            size_t pos = random() % (model.size() + 1);
+            seq.insert(pos, id);
+            model.insert(model.begin() + pos, id);
+        }
+
+        // Erase one ID by position
+        else if (change < 60) {
+            if (!model.empty()) {
+                size_t pos = random() % model.size();
+                uint32_t erased = seq.erase(pos);
+                if (erased != model[pos]) {
+                    fail(step, s, "erase returned " + to_string(erased) + " but should have returned " + to_string(model[pos]));
+                }
+                model.erase(model.begin() + pos);
+            }
+        }
+
+        // Erase every copy of one ID
+        else if (change < 70) {
+            size_t copies = count(model.begin(), model.end(), id);
+            size_t erased = seq.erase_all(id);
+            if (erased != copies) {
+                fail(step, s, "erase_all took out " + to_string(erased) + " copies but should have taken out " + to_string(copies));
+            }
+            model.erase(remove(model.begin(), model.end(), id), model.end());
+        }
+
+        // Insert a batch, small or large
+        else if (change < 80) {
+            size_t n = random() % 2 == 0 ? random() % 8 + 1 : random() % 2000 + 1;
+            vector<uint32_t> ids(n);
+            for (size_t i=0; i<n; i++) {
+                ids[i] = random() % range;
+            }
+            size_t pos = random() % (model.size() + 1);
+            seq.insert(pos, ids);
+            model.insert(model.begin() + pos, ids.begin(), ids.end());
+        }
+
+        // Erase every copy of a batch of IDs, few or many
+        else if (change < 88) {
+            size_t n = random() % 2 == 0 ? 1 : random() % 200 + 1;
+            vector<uint32_t> ids(n);
+            for (size_t i=0; i<n; i++) {
+                ids[i] = random() % range;
+            }
+            vector<uint32_t> kept;
+            for (size_t i=0; i<model.size(); i++) {
+                if (find(ids.begin(), ids.end(), model[i]) == ids.end()) {
+                    kept.push_back(model[i]);
+                }
+            }
+            size_t erased = seq.erase_all(ids);
+            if (erased != model.size() - kept.size()) {
+                fail(step, s, "erase_all of a batch took out " + to_string(erased) + " copies but should have taken out " + to_string(model.size() - kept.size()));
+            }
+            model.swap(kept);
+        }
+
+        // Replace whole sequence, sometimes with a much shorter one
+        else if (change < 92) {
+            size_t n = random() % (change == 90 ? 50 : 3000);
+            vector<uint32_t> ids(n);
+            for (size_t i=0; i<n; i++) {
+                ids[i] = random() % range;
+            }
+            seq.assign(ids);
+            model = ids;
+        }
+
+        // Copy another sequence, so both share leaves and nodes
+        else {
+            int other = random() % SEQUENCES;
+            if (random() % 2 == 0) {
+                seq = seqs[other];
+            }
+            else {
+                id_sequence copy(seqs[other]);
+                seq = move(copy);
+            }
+            model = models[other];
+        }
+
+        quick_check(step, s, seq, model, id, random);
+
+        // Changing one sequence must leave every copy of it as it was
+        if (step % FULL_CHECK_EVERY == 0) {
+            for (int t=0; t<SEQUENCES; t++) {
+                full_check(step, t, seqs[t], models[t]);
+            }
+        }
+    }
+
+    for (int t=0; t<SEQUENCES; t++) {
+        full_check(steps, t, seqs[t], models[t]);
+    }
+
+    cout << "SUCCESS! " << steps << " changes checked with seed " << seed << "." << endl;
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ Title          : search_bench.cpp
+
+ Description    : Measures how fast titles of a songs file are searched for a
+                    key, the way searches worked before folded_column (making a
+                    lowercase copy of each title and calling find on it) and
+                    with folded_column::find_all over one case folded block.
+                    Only the search is timed, not loading titles or folding
+                    the column.
+
+ Usage          : ./search_bench mysongs.csv [repeats] [key ...]
+                (repeats is how many times each key is searched for by each
+                    way, 3 if not given. Fastest pass is reported. A few keys
+                    are searched for if none are given.)
+
+ Build with     : g++ -O2 -std=c++17 -o search_bench bench/search_bench.cpp
+                    folded_column.cpp row_tokenizer.cpp -I.
+                (add -mavx2 to use 32 byte compares)
+
+ *******************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <cstdint>
+
+#include "row_tokenizer.h"
+#include "folded_column.h"
+
+using namespace std;
+
+/* Convert a string to lowercase, as the database used to for each title */
+string lowercase(string word) {
+    transform(word.begin(), word.end(), word.begin(), ::tolower);
+    return word;
+}
+
+/* Finds every title containing key by lowercasing each title and calling find,
+    as the database used to. Returns number of titles found.
+ */
+size_t find_with_copies(const vector<string> &titles, const string &key) {
+
+    string key_lower = lowercase(key);
+    size_t found = 0;
+
+    for (size_t i=0; i<titles.size(); i++) {
+        string title_lower = lowercase(titles[i]);
+        if (title_lower.find(key_lower) != title_lower.npos) {
+            found++;
+        }
+    }
+
+    return found;
+}
+
+/* Finds every title containing key with one scan of the folded column.
+    Returns number of titles found.
+ */
+size_t find_with_column(const folded_column &column, const string &key) {
+
+    string key_lower;
+    fold_case(key, key_lower);
+    vector<uint32_t> ids;
+    column.find_all(key_lower, 0, column.size(), ids);
+
+    return ids.size();
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " mysongs.csv [repeats] [key ...]" << endl;
+        return 1;
+    }
+    int repeats = argc > 2 ? atoi(argv[2]) : 3;
+    if (repeats < 1) {
+        repeats = 1;
+    }
+    vector<string> keys;
+    for (int i=3; i<argc; i++) {
+        keys.push_back(argv[i]);
+    }
+    if (keys.empty()) {
+        keys = {"hello day", "fire in", "love", "zzz"};
+    }
+
+    ifstream readf(argv[1], ios::binary);
+    if (!readf) {
+        cerr << "ERROR: Could not open " << argv[1] << endl;
+        return 1;
+    }
+    ostringstream contents;
+    contents << readf.rdbuf();
+    string text = contents.str();
+
+    // Titles are the first field of every row after the field headers
+    vector<string> titles;
+    folded_column column;
+    row_tokenizer tokens(text.data(), text.data() + text.size());
+    row_fields r;
+    bool headers = true;
+    while (tokens.next(r)) {
+        if (headers) {
+            headers = false;
+            continue;
+        }
+        string title;
+        for (size_t j=0; j<r.text[0].size(); j++) {
+            if (r.text[0][j] != '\"') {
+                title += r.text[0][j];
+            }
+        }
+        column.add(title);
+        titles.push_back(title);
+    }
+
+    size_t bytes = 0;
+    for (size_t i=0; i<titles.size(); i++) {
+        bytes += titles[i].size() + 1;
+    }
+
+    for (size_t k=0; k<keys.size(); k++) {
+        double best_copies = 0, best_column = 0;
+        size_t found_copies = 0, found_column = 0;
+
+        for (int i=0; i<repeats; i++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            found_copies = find_with_copies(titles, keys[k]);
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (i == 0 || secs < best_copies) {
+                best_copies = secs;
+            }
+
+            start = chrono::steady_clock::now();
+            found_column = find_with_column(column, keys[k]);
+            secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (i == 0 || secs < best_column) {
+                best_column = secs;
+            }
+        }
+
+        if (found_copies != found_column) {
+            cerr << "ERROR: \"" << keys[k] << "\" was found in " << found_copies << " titles by copying but " << found_column << " titles by the column" << endl;
+            return 1;
+        }
+
+        cout << "\"" << keys[k] << "\" (" << found_column << " of " << titles.size() << " titles)" << endl;
+        cout << "    lowercase + find: " << best_copies * 1000 << " ms, " << titles.size() / best_copies / 1e6 << " million rows/s" << endl;
+        cout << "    folded_column   : " << best_column * 1000 << " ms, " << titles.size() / best_column / 1e6 << " million rows/s, " << bytes / best_column / 1e9 << " GB/s" << endl;
+    }
+
+    return 0;
+}
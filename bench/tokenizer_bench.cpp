@@ -0,0 +1,145 @@
+/*******************************************************************************
+ Title          : tokenizer_bench.cpp
+
+ Description    : Measures how fast rows of a songs file are split into fields
+                    with their double quotes removed, the way the loader did
+                    before row_tokenizer (getline on a stringstream for each
+                    line and each field, then erasing quotes one character at
+                    a time) and with row_tokenizer. Only splitting and
+                    unquoting are timed, not checking fields or storing songs.
+
+ Usage          : ./tokenizer_bench mysongs.csv [repeats]
+                (repeats is how many times each splitter reads the whole file,
+                    3 if not given. Fastest pass is reported.)
+
+ Build with     : g++ -O2 -std=c++17 -o tokenizer_bench
+                    bench/tokenizer_bench.cpp row_tokenizer.cpp -I.
+
+ *******************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "row_tokenizer.h"
+
+using namespace std;
+
+/* Splits every line of text with getline and removes double quotes from each
+    field with erase, as the loader used to. Returns number of rows and adds
+    up the length of every field in bytes, so nothing is optimized away.
+ */
+size_t split_with_getline(const string &text, size_t &bytes) {
+
+    istringstream readf(text);
+    string line;
+    size_t rows = 0;
+
+    while (getline(readf, line)) {
+
+        istringstream ss(line);
+        vector<string> song_fields;
+        string field;
+        while (getline(ss, field, '\t')) {
+            song_fields.push_back(field);
+        }
+
+        for (size_t i=0; i<song_fields.size(); i++) {
+            for (size_t j=0; j<song_fields[i].length(); j++) {
+                if (song_fields[i][j] == '\"') {
+                    song_fields[i].erase(song_fields[i].begin()+j);
+                    j--;
+                }
+            }
+            bytes += song_fields[i].size();
+        }
+
+        rows++;
+    }
+
+    return rows;
+}
+
+/* Splits every row of text with row_tokenizer. Fields with quotes inside them
+    are copied without the quotes, as the loader does.
+ */
+size_t split_with_tokenizer(const string &text, size_t &bytes) {
+
+    row_tokenizer tokens(text.data(), text.data() + text.size());
+    row_fields r;
+    string unquoted;
+    size_t rows = 0;
+
+    while (tokens.next(r)) {
+        size_t fields = r.count < MAX_ROW_FIELDS ? r.count : MAX_ROW_FIELDS;
+        for (size_t i=0; i<fields; i++) {
+            if (r.inner_quotes[i]) {
+                unquoted.clear();
+                for (size_t j=0; j<r.text[i].size(); j++) {
+                    if (r.text[i][j] != '\"') {
+                        unquoted += r.text[i][j];
+                    }
+                }
+                bytes += unquoted.size();
+            }
+            else {
+                bytes += r.text[i].size();
+            }
+        }
+        rows++;
+    }
+
+    return rows;
+}
+
+/* Times the fastest of repeats passes of split over text, and writes rows per
+    second and megabytes per second.
+ */
+void time_splitter(const string &name, size_t (*split)(const string &, size_t &), const string &text, int repeats) {
+
+    double best = 0;
+    size_t rows = 0, bytes = 0;
+
+    for (int i=0; i<repeats; i++) {
+        bytes = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        rows = split(text, bytes);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (i == 0 || secs < best) {
+            best = secs;
+        }
+    }
+
+    cout << name << ": " << rows << " rows, " << bytes << " field bytes, " << best * 1000 << " ms, " << rows / best / 1e6 << " million rows/s, " << text.size() / best / 1e6 << " MB/s" << endl;
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " mysongs.csv [repeats]" << endl;
+        return 1;
+    }
+    int repeats = argc > 2 ? atoi(argv[2]) : 3;
+    if (repeats < 1) {
+        repeats = 1;
+    }
+
+    // Whole file is read into memory first, so only splitting is timed
+    ifstream readf(argv[1], ios::binary);
+    if (!readf) {
+        cerr << "ERROR: Could not open " << argv[1] << endl;
+        return 1;
+    }
+    ostringstream contents;
+    contents << readf.rdbuf();
+    string text = contents.str();
+
+    time_splitter("getline + erase", split_with_getline, text, repeats);
+    time_splitter("row_tokenizer  ", split_with_tokenizer, text, repeats);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "folded_column.h"
+
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Bytes compared at once. Text too short for a whole block is compared one
+// byte at a time.
+#if defined(__AVX2__)
+static const size_t BLOCK_BYTES = 32;
+#elif defined(__SSE2__)
+static const size_t BLOCK_BYTES = 16;
+#endif
+
+/* Compares a block of text against the first and last byte of the key at
+    once: the first byte at each position of the block, and the last byte
+    where the key would end if it started there. Only positions where both
+    match are compared in full. Keys of a single byte are left to memchr.
+ */
+size_t find_bytes(const char *text, size_t n, string_view key) {
+
+    size_t k = key.size();
+    if (k == 0) {
+        return 0;
+    }
+    if (k > n) {
+        return string_view::npos;
+    }
+    if (k == 1) {
+        const char *hit = static_cast<const char *>(memchr(text, key[0], n));
+        return hit == NULL ? string_view::npos : hit - text;
+    }
+
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i first = _mm256_set1_epi8(key[0]);
+    __m256i last = _mm256_set1_epi8(key[k-1]);
+    for (; i + k - 1 + BLOCK_BYTES <= n; i += BLOCK_BYTES) {
+        __m256i starts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        __m256i ends = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + k - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(starts, first), _mm256_cmpeq_epi8(ends, last)));
+        while (mask != 0) {
+            size_t at = i + __builtin_ctz(mask);
+            if (memcmp(text + at + 1, key.data() + 1, k - 2) == 0) {
+                return at;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i first = _mm_set1_epi8(key[0]);
+    __m128i last = _mm_set1_epi8(key[k-1]);
+    for (; i + k - 1 + BLOCK_BYTES <= n; i += BLOCK_BYTES) {
+        __m128i starts = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i ends = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + k - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, first), _mm_cmpeq_epi8(ends, last)));
+        while (mask != 0) {
+            size_t at = i + __builtin_ctz(mask);
+            if (memcmp(text + at + 1, key.data() + 1, k - 2) == 0) {
+                return at;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Positions left over after the last whole block
+    for (; i + k <= n; i++) {
+        if (text[i] == key[0] && text[i+k-1] == key[k-1] && memcmp(text + i + 1, key.data() + 1, k - 2) == 0) {
+            return i;
+        }
+    }
+
+    return string_view::npos;
+}
+
+/* Folds each character of s into out */
+void fold_case(string_view s, string &out) {
+    out.resize(s.size());
+    for (size_t i=0; i<s.size(); i++) {
+        out[i] = (char)tolower((unsigned char)s[i]);
+    }
+}
+
+/* Default constructor. First string starts at the start of text. */
+folded_column::folded_column(): first(1, 0) {}
+
+/* Folds s onto the end of text and notes where the next string starts */
+void folded_column::add(string_view s) {
+    size_t at = text.size();
+    text.resize(at + s.size() + 1);
+    for (size_t i=0; i<s.size(); i++) {
+        text[at + i] = (char)tolower((unsigned char)s[i]);
+    }
+    text[at + s.size()] = '\n';
+    first.push_back(text.size());
+}
+
+/* Empties text and first */
+void folded_column::clear() {
+    text.clear();
+    first.assign(1, 0);
+}
+
+/* Searches string id, leaving out the line break that follows it */
+bool folded_column::contains(uint32_t id, string_view key_lower) const {
+    return find_bytes(text.data() + first[id], first[id+1] - first[id] - 1, key_lower) != string_view::npos;
+}
+
+/* Searches strings from up to to as one block of text. Each occurrence found
+    is looked up in first to find which string it is in, and the search
+    carries on from the start of the next string. No string contains a line
+    break, so a key with one in it is in none of them, and no other key can
+    be found across the end of a string.
+ */
+void folded_column::find_all(string_view key_lower, uint32_t from, uint32_t to, vector<uint32_t> &ids) const {
+
+    ids.clear();
+
+    if (from >= to || key_lower.find('\n') != key_lower.npos) {
+        return;
+    }
+
+    size_t pos = first[from];
+    size_t end = first[to];
+    while (pos < end) {
+        size_t hit = find_bytes(text.data() + pos, end - pos, key_lower);
+        if (hit == string_view::npos) {
+            return;
+        }
+
+        // String hit is in
+        uint32_t id = (uint32_t)(upper_bound(first.begin() + from, first.begin() + to + 1, pos + hit) - first.begin() - 1);
+        ids.push_back(id);
+        pos = first[id + 1];
+    }
+}
+
+/* Returns text from first[id] up to the line break before first[id+1] */
+string_view folded_column::operator [] (uint32_t id) const {
+    return string_view(text.data() + first[id], first[id+1] - first[id] - 1);
+}
+
+/* Returns one less than the number of starts in first */
+uint32_t folded_column::size() const { return (uint32_t)first.size() - 1; }
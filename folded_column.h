@@ -0,0 +1,113 @@
+/*****************************************************************************
+ Title:       folded_column.h
+ Description: Folded Column Class Definition (Header File)
+
+ A case folded copy of a list of strings, kept back to back in one block of
+ text so that it can be searched in a single pass.
+ - Strings are numbered from 0 in the order they are added, and each is
+ followed by a line break, which no song field contains.
+ - Finds every string containing a key, comparing 16 bytes at a time with
+ SSE2 (32 bytes at a time with AVX2 when built with -mavx2) against the
+ first and last byte of the key before comparing the rest.
+
+ *****************************************************************************/
+
+#ifndef ___folded_column__
+#define ___folded_column__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+/* size_t find_bytes(const char *text, size_t n, string_view key);
+ Returns position of the first occurrence of key in the n bytes starting at
+ text, or string_view::npos if there is none. An empty key is found at 0.
+ Bytes are compared exactly, so both must already be case folded for a case
+ insensitive search.
+ */
+size_t find_bytes(const char *text, size_t n, string_view key);
+
+/* void fold_case(string_view s, string &out);
+ Replaces out with s case folded the same way ::tolower folds each character.
+ Reuses the room out already has.
+ */
+void fold_case(string_view s, string &out);
+
+class folded_column {
+
+    // Every string, case folded, each followed by a line break
+    string text;
+
+    // Where each string starts in text, followed by where the next string
+    // would start
+    vector<size_t> first;
+
+public:
+
+/******************************************************************************
+     Folded column constructor
+******************************************************************************/
+
+    /* folded_column();
+     Default constructor for folded column class.
+        @post       Column is empty.
+     */
+    folded_column();
+
+/******************************************************************************
+     Adding strings
+******************************************************************************/
+
+    /* void add(string_view s);
+     Adds a case folded copy of s to the column with id size().
+     */
+    void add(string_view s);
+
+    /* void clear();
+     Removes every string from the column.
+     */
+    void clear();
+
+/******************************************************************************
+     Searching the column
+******************************************************************************/
+
+    /* bool contains(uint32_t id, string_view key_lower) const;
+     Returns true if string id contains key_lower.
+        @pre        id < size(). key_lower is already in lowercase.
+     */
+    bool contains(uint32_t id, string_view key_lower) const;
+
+    /* void find_all(string_view key_lower, uint32_t from, uint32_t to,
+            vector<uint32_t> &ids) const;
+     Finds every string from id from up to id to that contains key_lower,
+     scanning them as one block of text.
+        @param      string_view key_lower [in] key to search for, already in
+                                          lowercase
+        @param      uint32_t from   [in] id of first string to search
+        @param      uint32_t to     [in] one past id of last string to search
+        @param      vector<uint32_t> &ids [out] ids of strings that contain
+                                          key_lower, in increasing order
+        @pre        to <= size(), unless from >= to, in which case nothing is
+                    searched.
+     */
+    void find_all(string_view key_lower, uint32_t from, uint32_t to, vector<uint32_t> &ids) const;
+
+    /* string_view operator [] (uint32_t id) const;
+     Returns case folded string id, without the line break after it.
+        @pre        id < size().
+     */
+    string_view operator [] (uint32_t id) const;
+
+    /* uint32_t size() const;
+     Returns number of strings in the column.
+     */
+    uint32_t size() const;
+
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "fuzzy_index.h"
+
+#include <algorithm>
+
+/* Default constructor. Nothing to do until strings are indexed. */
+fuzzy_index::fuzzy_index() {}
+
+/* Interns every string in the range as a name, indexes the trigrams of each
+    name once, then sorts string ids by name, counting the strings with each
+    name first so each one's ids can be placed straight into name_ids.
+ */
+void fuzzy_index::build(const folded_column &column, uint32_t from, uint32_t to) {
+
+    names.clear();
+    trigrams.clear();
+
+    vector<uint32_t> name_of(to > from ? to - from : 0);
+    for (uint32_t i=from; i<to; i++) {
+        name_of[i - from] = names.intern(column[i]);
+    }
+
+    for (uint32_t n=0; n<names.size(); n++) {
+        trigrams.add(names[n]);
+    }
+
+    // Number of strings with each name, then where each name's ids start
+    name_first.assign(names.size() + 1, 0);
+    for (size_t i=0; i<name_of.size(); i++) {
+        name_first[name_of[i] + 1]++;
+    }
+    for (uint32_t n=0; n<names.size(); n++) {
+        name_first[n + 1] += name_first[n];
+    }
+
+    name_ids.resize(name_of.size());
+    vector<uint32_t> next(name_first.begin(), name_first.end() - 1);
+    for (size_t i=0; i<name_of.size(); i++) {
+        name_ids[next[name_of[i]]++] = from + (uint32_t)i;
+    }
+}
+
+/* A part of a name within max_distance edits of the key still has all but
+    3 * max_distance of the key's distinct trigrams, since an edit can only
+    break the trigrams that overlap it. Names sharing fewer are skipped. The
+    rest are compared in full and the k best kept. If the key has no more
+    than 3 * max_distance distinct trigrams, a name sharing none of them can
+    still be close enough, so every name is compared.
+ */
+void fuzzy_index::closest(string_view key_lower, int max_distance, size_t k, vector<fuzzy_match> &matches) const {
+
+    matches.clear();
+
+    vector<uint16_t> shared(names.size(), 0);
+    int distinct = (int)trigrams.count_shared(key_lower, shared);
+    int needed = distinct - 3 * max_distance;
+
+    for (uint32_t n=0; n<names.size(); n++) {
+        if (needed > 0 && shared[n] < needed) {
+            continue;
+        }
+
+        int d = substring_distance(key_lower, names[n]);
+        if (d <= max_distance) {
+            fuzzy_match m = {n, d};
+            matches.push_back(m);
+        }
+    }
+
+    // Fewest edits, then closest length, then first name seen
+    int key_size = (int)key_lower.size();
+    auto closer = [&](const fuzzy_match &a, const fuzzy_match &b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        int a_gap = abs((int)names[a.name].size() - key_size);
+        int b_gap = abs((int)names[b.name].size() - key_size);
+        if (a_gap != b_gap) {
+            return a_gap < b_gap;
+        }
+        return a.name < b.name;
+    };
+
+    if (matches.size() > k) {
+        partial_sort(matches.begin(), matches.begin() + k, matches.end(), closer);
+        matches.resize(k);
+    }
+    else {
+        sort(matches.begin(), matches.end(), closer);
+    }
+}
+
+/* Edit distance between key and the best matching part of text. Works down
+    text one character at a time, keeping for every prefix of key the fewest
+    edits turning it into a part of text that ends at the current character.
+    A part may start anywhere, so the empty prefix always costs nothing.
+ */
+int fuzzy_index::substring_distance(string_view key, string_view text) {
+
+    size_t m = key.size();
+    vector<int> column(m + 1);
+    for (size_t i=0; i<=m; i++) {
+        column[i] = (int)i;
+    }
+
+    int best = (int)m;
+    for (size_t j=0; j<text.size(); j++) {
+        int diagonal = column[0];
+        for (size_t i=1; i<=m; i++) {
+            int above = column[i];
+            int cost = diagonal + (key[i-1] != text[j] ? 1 : 0);
+            cost = min(cost, above + 1);
+            cost = min(cost, column[i-1] + 1);
+            column[i] = cost;
+            diagonal = above;
+        }
+        best = min(best, column[m]);
+    }
+
+    return best;
+}
+
+/* Returns names[n] */
+string_view fuzzy_index::name(uint32_t n) const { return names[n]; }
+
+/* Appends name_ids from name_first[n] up to name_first[n+1] */
+void fuzzy_index::ids_of(uint32_t n, vector<uint32_t> &ids) const {
+    ids.insert(ids.end(), name_ids.begin() + name_first[n], name_ids.begin() + name_first[n + 1]);
+}
@@ -0,0 +1,113 @@
+/*****************************************************************************
+ Title:       fuzzy_index.h
+ Description: Fuzzy Index Class Definition (Header File)
+
+ Index for typo tolerant searches over the strings of a folded column.
+ - Strings that are the same once case folded are kept once, as a name, with
+ the ids of every string that has it.
+ - Finds the names closest to a key: those with a part that is within a few
+ edits (characters inserted, deleted or changed) of the key. Names that share
+ too few trigrams with the key to be that close are never compared.
+
+ *****************************************************************************/
+
+#ifndef ___fuzzy_index__
+#define ___fuzzy_index__
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "folded_column.h"
+#include "string_dictionary.h"
+#include "trigram_index.h"
+
+using namespace std;
+
+// A name found by a fuzzy search, and how many edits away from the key it is
+struct fuzzy_match {
+    uint32_t name;
+    int distance;
+};
+
+class fuzzy_index {
+
+    // Distinct case folded strings, and a trigram index of them
+    string_dictionary names;
+    trigram_index trigrams;
+
+    // Ids of the strings with each name, name_first[n] up to name_first[n+1]
+    // in name_ids
+    vector<uint32_t> name_first;
+    vector<uint32_t> name_ids;
+
+public:
+
+/******************************************************************************
+     Fuzzy index constructor
+******************************************************************************/
+
+    /* fuzzy_index();
+     Default constructor for fuzzy index class.
+        @post       Index is empty.
+     */
+    fuzzy_index();
+
+/******************************************************************************
+     Building the index
+******************************************************************************/
+
+    /* void build(const folded_column &column, uint32_t from, uint32_t to);
+     Indexes strings from id from up to id to of column, replacing anything
+     indexed before.
+        @pre        from <= to <= column.size(). column is not changed while
+                    the index is used.
+        @post       Every distinct string is a name, numbered in the order it
+                    first appears.
+     */
+    void build(const folded_column &column, uint32_t from, uint32_t to);
+
+/******************************************************************************
+     Searching the index
+******************************************************************************/
+
+    /* void closest(string_view key_lower, int max_distance, size_t k,
+            vector<fuzzy_match> &matches) const;
+     Finds the k names closest to key_lower.
+        @param      string_view key_lower [in] key, already in lowercase
+        @param      int max_distance [in] most edits a name can be away from
+                                    key_lower to be found
+        @param      size_t k        [in] most names to find
+        @param      vector<fuzzy_match> &matches [out] names found, closest
+                                    first
+        @post       matches holds up to k names with a part at most
+                    max_distance edits from key_lower, fewest edits first.
+                    Names with as many edits are ordered by how close their
+                    length is to the length of key_lower, then by name. Names
+                    that share fewer trigrams with key_lower than any name
+                    that close must are skipped without being compared.
+     */
+    void closest(string_view key_lower, int max_distance, size_t k, vector<fuzzy_match> &matches) const;
+
+    /* static int substring_distance(string_view key, string_view text);
+     Returns fewest edits that turn key into some part of text.
+     */
+    static int substring_distance(string_view key, string_view text);
+
+/******************************************************************************
+     Returning fuzzy index variables / characteristics
+******************************************************************************/
+
+    /* string_view name(uint32_t n) const;
+     Returns name n.
+     */
+    string_view name(uint32_t n) const;
+
+    /* void ids_of(uint32_t n, vector<uint32_t> &ids) const;
+     Appends ids of every string with name n to ids, in increasing order.
+     */
+    void ids_of(uint32_t n, vector<uint32_t> &ids) const;
+
+};
+
+#endif
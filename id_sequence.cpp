@@ -0,0 +1,528 @@
+#include "id_sequence.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+/* Default constructor. Root is an empty leaf, labelled halfway, so there is
+    room for labels on either side of it.
+ */
+id_sequence::id_sequence(): root(make_shared<node>()), index_built(true), relabel_needed(false) {
+    root->leaf = true;
+    root->count = 0;
+    root->label = UINT64_MAX / 2;
+}
+
+/* Copy constructor. Root is shared, and index left to be built. */
+id_sequence::id_sequence(const id_sequence &other): root(other.root), index_built(false), relabel_needed(false) {}
+
+/* Shares root of other, and drops index, to be built again */
+id_sequence &id_sequence::operator=(const id_sequence &other) {
+    if (this != &other) {
+        root = other.root;
+        index.clear();
+        index_built = false;
+    }
+    return *this;
+}
+
+/* Nodes are held only by the nodes above them, so a node held once is held
+    by this sequence alone, once every node above it is.
+ */
+id_sequence::node &id_sequence::own(shared_ptr<node> &n) {
+    if (n.use_count() > 1) {
+        n = make_shared<node>(*n);
+    }
+    return *n;
+}
+
+/* Leaves are visited in order of label, so labels of each ID are added in
+    order too, without searching.
+ */
+void id_sequence::build_index() const {
+
+    if (index_built) {
+        return;
+    }
+
+    index.clear();
+    visit(*root, [&](const node &l) {
+        for (size_t i=0; i<l.ids.size(); i++) {
+            places &p = index[l.ids[i]];
+            p.total++;
+            if (p.leaves.empty() || p.leaves.back().first != l.label) {
+                p.leaves.push_back(make_pair(l.label, (uint32_t)1));
+            }
+            else {
+                p.leaves.back().second++;
+            }
+        }
+    });
+    index_built = true;
+}
+
+/* Skips whole children until pos falls inside one */
+size_t id_sequence::child_at(const node &n, size_t &pos, bool at_end) {
+    size_t i = 0;
+    while (i + 1 < n.children.size() && (at_end ? pos > n.children[i]->count : pos >= n.children[i]->count)) {
+        pos -= n.children[i]->count;
+        i++;
+    }
+    return i;
+}
+
+/* Last child whose first leaf is labelled label or less */
+size_t id_sequence::child_labelled(const node &n, uint64_t label) {
+    size_t i = 0;
+    while (i + 1 < n.children.size() && n.children[i + 1]->label <= label) {
+        i++;
+    }
+    return i;
+}
+
+/* Leaves of an ID are kept in order of label, so the one to count in is
+    found with a binary search.
+ */
+void id_sequence::index_add(uint32_t id, uint64_t label, uint32_t n) {
+
+    if (!index_built) {
+        return;
+    }
+
+    places &p = index[id];
+    p.total += n;
+
+    vector< pair<uint64_t, uint32_t> >::iterator it = lower_bound(p.leaves.begin(), p.leaves.end(), make_pair(label, (uint32_t)0));
+    if (it != p.leaves.end() && it->first == label) {
+        it->second += n;
+    }
+    else {
+        p.leaves.insert(it, make_pair(label, n));
+    }
+}
+
+/* A leaf holding no more copies is dropped, and an ID with no copies left */
+void id_sequence::index_remove(uint32_t id, uint64_t label, uint32_t n) {
+
+    if (!index_built) {
+        return;
+    }
+
+    unordered_map<uint32_t, places>::iterator found = index.find(id);
+    places &p = found->second;
+
+    vector< pair<uint64_t, uint32_t> >::iterator it = lower_bound(p.leaves.begin(), p.leaves.end(), make_pair(label, (uint32_t)0));
+    it->second -= n;
+    if (it->second == 0) {
+        p.leaves.erase(it);
+    }
+
+    p.total -= n;
+    if (p.total == 0) {
+        index.erase(found);
+    }
+}
+
+/* One ID at a time */
+void id_sequence::index_move(const uint32_t *ids, size_t n, uint64_t from, uint64_t to) {
+    if (from == to || !index_built) {
+        return;
+    }
+    for (size_t i=0; i<n; i++) {
+        index_remove(ids[i], from, 1);
+        index_add(ids[i], to, 1);
+    }
+}
+
+/* Top half goes to the new node. Counts of both are worked out again. */
+shared_ptr<id_sequence::node> id_sequence::split(node &n, uint64_t label) {
+
+    shared_ptr<node> top = make_shared<node>();
+    top->leaf = n.leaf;
+
+    if (n.leaf) {
+        size_t half = n.ids.size() / 2;
+        top->ids.assign(n.ids.begin() + half, n.ids.end());
+        n.ids.resize(half);
+        top->count = top->ids.size();
+        top->label = label;
+        n.count = n.ids.size();
+        index_move(top->ids.data(), top->ids.size(), n.label, label);
+        return top;
+    }
+
+    size_t half = n.children.size() / 2;
+    top->children.assign(n.children.begin() + half, n.children.end());
+    n.children.resize(half);
+    top->count = 0;
+    for (size_t i=0; i<top->children.size(); i++) {
+        top->count += top->children[i]->count;
+    }
+    top->label = top->children[0]->label;
+    n.count -= top->count;
+    return top;
+}
+
+/* Adds id to the leaf holding pos, then splits each node on the way back up
+    that has grown too full. A leaf split in two labels its top half halfway
+    to the next leaf, but no further than LABEL_STEP_MAX past itself when the
+    next leaf is far off, so songs added at the end leave room for more. If
+    there is no label free, leaves are labelled again under the lowest node
+    on the way back up with LABEL_GAP_MIN labels for each of them.
+ */
+shared_ptr<id_sequence::node> id_sequence::insert_at(node &n, size_t pos, uint32_t id, uint64_t bound) {
+
+    n.count++;
+
+    if (n.leaf) {
+        n.ids.insert(n.ids.begin() + pos, id);
+        index_add(id, n.label, 1);
+        if (n.ids.size() <= LEAF_MAX) {
+            return shared_ptr<node>();
+        }
+
+        uint64_t gap = bound - n.label;
+        if (gap < 2) {
+            relabel_needed = true;
+            return split(n, n.label);
+        }
+        return split(n, n.label + (gap / 2 < LABEL_STEP_MAX ? gap / 2 : LABEL_STEP_MAX));
+    }
+
+    size_t i = child_at(n, pos, true);
+    uint64_t child_bound = i + 1 < n.children.size() ? n.children[i + 1]->label : bound;
+    shared_ptr<node> top = insert_at(own(n.children[i]), pos, id, child_bound);
+    if (top) {
+        n.children.insert(n.children.begin() + i + 1, top);
+    }
+
+    if (relabel_needed) {
+        size_t leaves = count_leaves(n);
+        uint64_t step = (bound - n.label) / leaves;
+        if (step >= LABEL_GAP_MIN) {
+            uint64_t next = n.label;
+            relabel(n, next, step);
+            relabel_needed = false;
+        }
+    }
+
+    return n.children.size() > FANOUT_MAX ? split(n, 0) : shared_ptr<node>();
+}
+
+/* Takes id out of the leaf holding pos, then rebalances each node on the way
+    back up that has too few IDs or children left.
+ */
+uint32_t id_sequence::erase_at(node &n, size_t pos) {
+
+    n.count--;
+
+    if (n.leaf) {
+        uint32_t id = n.ids[pos];
+        n.ids.erase(n.ids.begin() + pos);
+        index_remove(id, n.label, 1);
+        return id;
+    }
+
+    size_t i = child_at(n, pos, false);
+    uint32_t id = erase_at(own(n.children[i]), pos);
+    rebalance(n, i);
+    return id;
+}
+
+/* Walks down by label, takes every copy of id out of the leaf, then
+    rebalances each node on the way back up like erase_at.
+ */
+size_t id_sequence::erase_from_leaf(node &n, uint64_t label, uint32_t id) {
+
+    if (n.leaf) {
+        vector<uint32_t>::iterator kept = remove(n.ids.begin(), n.ids.end(), id);
+        size_t removed = n.ids.end() - kept;
+        n.ids.erase(kept, n.ids.end());
+        n.count -= removed;
+        if (removed > 0) {
+            index_remove(id, n.label, (uint32_t)removed);
+        }
+        return removed;
+    }
+
+    size_t i = child_labelled(n, label);
+    size_t removed = erase_from_leaf(own(n.children[i]), label, id);
+    n.count -= removed;
+    rebalance(n, i);
+    return removed;
+}
+
+/* Child i and the neighbour after it, or before it if i is last, are put
+    together, then split evenly again if that is too many for one. IDs of a
+    leaf merged into the one before it are counted in that leaf, and the
+    label of the leaf merged away is used again if the leaves are split.
+    The leaf or node merged away is only read, as other copies may hold it.
+ */
+void id_sequence::rebalance(node &n, size_t i) {
+
+    node &c = *n.children[i];
+    if ((c.leaf ? c.ids.size() >= LEAF_MIN : c.children.size() >= FANOUT_MIN) || n.children.size() < 2) {
+        return;
+    }
+
+    size_t a = i + 1 < n.children.size() ? i : i - 1;
+    shared_ptr<node> right = n.children[a + 1];
+    node &left = own(n.children[a]);
+
+    if (left.leaf) {
+        index_move(right->ids.data(), right->ids.size(), right->label, left.label);
+        left.ids.insert(left.ids.end(), right->ids.begin(), right->ids.end());
+    }
+    else {
+        left.children.insert(left.children.end(), right->children.begin(), right->children.end());
+    }
+    left.count += right->count;
+    n.children.erase(n.children.begin() + a + 1);
+
+    if (left.leaf ? left.ids.size() > LEAF_MAX : left.children.size() > FANOUT_MAX) {
+        n.children.insert(n.children.begin() + a + 1, split(left, right->label));
+    }
+}
+
+/* A root left with one child is replaced by that child */
+void id_sequence::shrink_root() {
+    while (!root->leaf && root->children.size() == 1) {
+        root = root->children[0];
+    }
+}
+
+/* Leaves are at the bottom of every child */
+size_t id_sequence::count_leaves(const node &n) {
+    if (n.leaf) {
+        return 1;
+    }
+    size_t leaves = 0;
+    for (size_t i=0; i<n.children.size(); i++) {
+        leaves += count_leaves(*n.children[i]);
+    }
+    return leaves;
+}
+
+/* Leaves in order, each moving its IDs in index to its new label */
+void id_sequence::relabel(node &n, uint64_t &next, uint64_t step) {
+    if (n.leaf) {
+        index_move(n.ids.data(), n.ids.size(), n.label, next);
+        n.label = next;
+        next += step;
+        return;
+    }
+    for (size_t i=0; i<n.children.size(); i++) {
+        relabel(own(n.children[i]), next, step);
+    }
+    n.label = n.children[0]->label;
+}
+
+/* Every run, one after another */
+void id_sequence::copy_to(vector<uint32_t> &out) const {
+    for_each_run([&](const uint32_t *run, size_t n) {
+        out.insert(out.end(), run, run + n);
+    });
+}
+
+/* Leaves in order, left to right */
+void id_sequence::visit(const node &n, const function<void(const node &)> &f) {
+    if (n.leaf) {
+        f(n);
+        return;
+    }
+    for (size_t i=0; i<n.children.size(); i++) {
+        visit(*n.children[i], f);
+    }
+}
+
+/* A root that splits gets a new root above it, holding both halves. If no
+    node had room to label leaves again, every leaf is, spread over every
+    label.
+ */
+void id_sequence::insert(size_t pos, uint32_t id) {
+
+    shared_ptr<node> top = insert_at(own(root), pos, id, UINT64_MAX);
+    if (top) {
+        shared_ptr<node> above = make_shared<node>();
+        above->leaf = false;
+        above->count = root->count + top->count;
+        above->label = root->label;
+        above->children.push_back(root);
+        above->children.push_back(top);
+        root = above;
+    }
+
+    if (relabel_needed) {
+        uint64_t next = 0;
+        relabel(*root, next, UINT64_MAX / (count_leaves(*root) + 1));
+        relabel_needed = false;
+    }
+}
+
+/* Erases from the root down */
+uint32_t id_sequence::erase(size_t pos) {
+    uint32_t id = erase_at(own(root), pos);
+    shrink_root();
+    return id;
+}
+
+/* Takes copies out a leaf at a time. Leaves holding id are looked up in
+    index again each time, as merging leaves changes their labels. If the
+    leaf index names holds no copy, index and labels disagree and the same
+    leaf would be looked up forever, so the program stops with an error.
+ */
+size_t id_sequence::erase_all(uint32_t id) {
+
+    build_index();
+
+    size_t removed = 0;
+    unordered_map<uint32_t, places>::iterator found = index.find(id);
+    while (found != index.end()) {
+        size_t erased = erase_from_leaf(own(root), found->second.leaves.front().first, id);
+        if (erased == 0) {
+            cerr << "ERROR: Playlist index lists song ID " << id << " in a part of the playlist that does not hold it.\n" << endl;
+            exit(-1);
+        }
+        removed += erased;
+        shrink_root();
+        found = index.find(id);
+    }
+    return removed;
+}
+
+/* One at a time, in order, each after the one before, if there are few.
+    Else the sequence is copied out with ids put in at pos and built again.
+ */
+void id_sequence::insert(size_t pos, const vector<uint32_t> &ids) {
+
+    if (ids.size() <= size() / BATCH_DIVISOR) {
+        for (size_t i=0; i<ids.size(); i++) {
+            insert(pos + i, ids[i]);
+        }
+        return;
+    }
+
+    vector<uint32_t> all;
+    all.reserve(size() + ids.size());
+    copy_to(all);
+    all.insert(all.begin() + pos, ids.begin(), ids.end());
+    assign(all);
+}
+
+/* IDs to take out are sorted, without repeats, and their copies counted in
+    index. Few copies are taken out a leaf at a time. Else every ID not to be
+    taken out is copied, found by binary search, and the sequence built again.
+ */
+size_t id_sequence::erase_all(const vector<uint32_t> &ids) {
+
+    vector<uint32_t> gone(ids);
+    sort(gone.begin(), gone.end());
+    gone.erase(unique(gone.begin(), gone.end()), gone.end());
+
+    size_t copies = 0;
+    for (size_t i=0; i<gone.size(); i++) {
+        copies += count(gone[i]);
+    }
+    if (copies == 0) {
+        return 0;
+    }
+
+    if (copies <= size() / BATCH_DIVISOR) {
+        for (size_t i=0; i<gone.size(); i++) {
+            erase_all(gone[i]);
+        }
+        return copies;
+    }
+
+    vector<uint32_t> kept;
+    kept.reserve(size() - copies);
+    for_each_run([&](const uint32_t *run, size_t n) {
+        for (size_t i=0; i<n; i++) {
+            if (!binary_search(gone.begin(), gone.end(), run[i])) {
+                kept.push_back(run[i]);
+            }
+        }
+    });
+    assign(kept);
+    return copies;
+}
+
+/* Cuts ids into as few leaves as hold them, of nearly equal size, labelled
+    evenly over every label, then groups each level into as few nodes as
+    hold it the same way, until one node is left. Index is built again.
+ */
+void id_sequence::assign(const vector<uint32_t> &ids) {
+
+    index.clear();
+    index_built = true;
+
+    vector< shared_ptr<node> > level;
+    size_t leaves = (ids.size() + LEAF_MAX - 1) / LEAF_MAX;
+    uint64_t step = UINT64_MAX / (leaves + 1);
+    for (size_t i=0; i<leaves; i++) {
+        shared_ptr<node> l = make_shared<node>();
+        l->leaf = true;
+        l->label = step * (i + 1);
+        l->ids.assign(ids.begin() + ids.size() * i / leaves, ids.begin() + ids.size() * (i + 1) / leaves);
+        l->count = l->ids.size();
+        for (size_t j=0; j<l->ids.size(); j++) {
+            index_add(l->ids[j], l->label, 1);
+        }
+        level.push_back(l);
+    }
+
+    while (level.size() > 1) {
+        vector< shared_ptr<node> > above;
+        size_t nodes = (level.size() + FANOUT_MAX - 1) / FANOUT_MAX;
+        for (size_t i=0; i<nodes; i++) {
+            shared_ptr<node> p = make_shared<node>();
+            p->leaf = false;
+            p->count = 0;
+            p->children.assign(level.begin() + level.size() * i / nodes, level.begin() + level.size() * (i + 1) / nodes);
+            for (size_t c=0; c<p->children.size(); c++) {
+                p->count += p->children[c]->count;
+            }
+            p->label = p->children[0]->label;
+            above.push_back(p);
+        }
+        level.swap(above);
+    }
+
+    if (level.empty()) {
+        root = make_shared<node>();
+        root->leaf = true;
+        root->count = 0;
+        root->label = UINT64_MAX / 2;
+    }
+    else {
+        root = level[0];
+    }
+}
+
+/* Walks down to the leaf holding pos */
+uint32_t id_sequence::at(size_t pos) const {
+    const node *n = root.get();
+    while (!n->leaf) {
+        n = n->children[child_at(*n, pos, false)].get();
+    }
+    return n->ids[pos];
+}
+
+/* Total kept in index */
+size_t id_sequence::count(uint32_t id) const {
+    build_index();
+    unordered_map<uint32_t, places>::const_iterator found = index.find(id);
+    return found == index.end() ? 0 : found->second.total;
+}
+
+/* Number of IDs under root */
+size_t id_sequence::size() const { return root->count; }
+
+/* Every leaf that holds any IDs, in order */
+void id_sequence::for_each_run(const function<void(const uint32_t *, size_t)> &f) const {
+    visit(*root, [&](const node &l) {
+        if (!l.ids.empty()) {
+            f(l.ids.data(), l.ids.size());
+        }
+    });
+}
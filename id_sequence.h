@@ -0,0 +1,294 @@
+/*****************************************************************************
+ Title:       id_sequence.h
+ Description: ID Sequence Class Definition (Header File)
+
+ Sequence of song IDs that can be added to, taken from and read anywhere by
+ position in time logarithmic in its length.
+ - IDs are kept in order in leaves of up to LEAF_MAX IDs each, under a tree
+ of nodes of up to FANOUT_MAX children, all leaves at the same depth.
+ - Every node counts the IDs under it, so the leaf holding any position is
+ found by walking down from the root, skipping whole children at a time.
+ - Leaves and nodes that fill up are split in two, and ones that empty out
+ are merged with, or take IDs from, a neighbour.
+ - Every leaf has a label, larger than the label of the leaf before it, and
+ every node the label of its first leaf, so a leaf is also found from its
+ label by walking down. An index keeps, for each ID, the labels of the
+ leaves holding it and how many times each does, so every copy of an ID is
+ found without reading the whole sequence.
+ - Copies share their leaves and nodes, so copying a sequence takes constant
+ time and memory. A leaf or node held by more than one copy is copied before
+ it is changed, so changing one copy copies only the nodes on the way down to
+ the leaves changed. A copy's index is built again the first time it is used.
+
+ *****************************************************************************/
+
+#ifndef ___id_sequence__
+#define ___id_sequence__
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+class id_sequence {
+
+    // A leaf, holding IDs, or a node, holding leaves or other nodes, with the
+    // number of IDs under it and the label of its first leaf
+    struct node {
+        bool leaf;
+        size_t count;
+        uint64_t label;
+        vector<uint32_t> ids;
+        vector< shared_ptr<node> > children;
+    };
+
+    // Where copies of an ID are: how many there are in all, and the label of
+    // each leaf holding any with how many it holds, in order of label
+    struct places {
+        size_t total;
+        vector< pair<uint64_t, uint32_t> > leaves;
+    };
+
+    // Top of the tree, always a leaf or a node with 2 or more children
+    shared_ptr<node> root;
+
+    // Where copies of each ID in the sequence are, if index_built. Built
+    // when first used after the sequence is copied.
+    mutable unordered_map<uint32_t, places> index;
+    mutable bool index_built;
+
+    // Set when a leaf is split with no label left between its neighbours.
+    // Leaves under the lowest node above it with room enough are labelled
+    // again, or every leaf if no node has.
+    bool relabel_needed;
+
+    // Most IDs in a leaf and children of a node, and fewest before they are
+    // merged with a neighbour
+    static const size_t LEAF_MAX = 256;
+    static const size_t LEAF_MIN = LEAF_MAX / 4;
+    static const size_t FANOUT_MAX = 32;
+    static const size_t FANOUT_MIN = FANOUT_MAX / 4;
+
+    // Batches of changes no bigger than the sequence divided by this are
+    // made one ID, or one leaf, at a time, as that is quicker than a pass
+    // over the whole sequence
+    static const size_t BATCH_DIVISOR = 64;
+
+    // Farthest past itself a leaf split in two labels its top half, and
+    // fewest labels between leaves labelled again under one node
+    static const uint64_t LABEL_STEP_MAX = (uint64_t)1 << 32;
+    static const uint64_t LABEL_GAP_MIN = 1 << 16;
+
+    /* static size_t child_at(const node &n, size_t &pos, bool at_end);
+     Finds child of n holding position pos, and makes pos a position in that
+     child. If at_end, a pos just past the end of a child is in that child,
+     not the next, so IDs added there go at the end of it.
+     */
+    static size_t child_at(const node &n, size_t &pos, bool at_end);
+
+    /* static node &own(shared_ptr<node> &n);
+     Copies *n into a new node held by n alone, if any other copy of the
+     sequence also holds it, and returns it, so it can be changed.
+     */
+    static node &own(shared_ptr<node> &n);
+
+    /* void build_index() const;
+     Builds index from the leaves, if it is not built.
+     */
+    void build_index() const;
+
+    /* static size_t child_labelled(const node &n, uint64_t label);
+     Finds child of n holding the leaf labelled label.
+     */
+    static size_t child_labelled(const node &n, uint64_t label);
+
+    /* void index_add(uint32_t id, uint64_t label, uint32_t n);
+     Counts n more copies of id in the leaf labelled label.
+     */
+    void index_add(uint32_t id, uint64_t label, uint32_t n);
+
+    /* void index_remove(uint32_t id, uint64_t label, uint32_t n);
+     Counts n fewer copies of id in the leaf labelled label.
+     */
+    void index_remove(uint32_t id, uint64_t label, uint32_t n);
+
+    /* void index_move(const uint32_t *ids, size_t n, uint64_t from,
+            uint64_t to);
+     Counts n IDs that moved from the leaf labelled from to the leaf labelled
+     to in the leaf labelled to instead.
+     */
+    void index_move(const uint32_t *ids, size_t n, uint64_t from, uint64_t to);
+
+    /* shared_ptr<node> split(node &n, uint64_t label);
+     Moves top half of n's IDs or children into a new node, which is
+     returned. A new leaf is labelled label.
+     */
+    shared_ptr<node> split(node &n, uint64_t label);
+
+    /* shared_ptr<node> insert_at(node &n, size_t pos, uint32_t id,
+            uint64_t bound);
+     Adds id at position pos under n. bound is the label of the first leaf
+     after n, or UINT64_MAX if there is none.
+        @return     shared_ptr<node> [out] node holding top half of n if n was
+                                    split because it was too full, else NULL
+     */
+    shared_ptr<node> insert_at(node &n, size_t pos, uint32_t id, uint64_t bound);
+
+    /* uint32_t erase_at(node &n, size_t pos);
+     Takes ID at position pos under n out, and returns it.
+     */
+    uint32_t erase_at(node &n, size_t pos);
+
+    /* size_t erase_from_leaf(node &n, uint64_t label, uint32_t id);
+     Takes every copy of id out of the leaf labelled label under n, and
+     returns how many there were.
+     */
+    size_t erase_from_leaf(node &n, uint64_t label, uint32_t id);
+
+    /* void rebalance(node &n, size_t i);
+     Merges child i of n with a neighbour, or shares IDs or children evenly
+     between them if they don't fit in one, if child i has too few.
+     */
+    void rebalance(node &n, size_t i);
+
+    /* void shrink_root();
+     Replaces a root left with one child by that child, until it has more.
+     */
+    void shrink_root();
+
+    /* static size_t count_leaves(const node &n);
+     Returns number of leaves under n.
+     */
+    static size_t count_leaves(const node &n);
+
+    /* void relabel(node &n, uint64_t &next, uint64_t step);
+     Labels leaves under n step apart, starting at next, and each node with
+     the label of its first leaf. Index is kept up to date.
+     */
+    void relabel(node &n, uint64_t &next, uint64_t step);
+
+    /* void copy_to(vector<uint32_t> &out) const;
+     Appends every ID in the sequence to out, in order.
+     */
+    void copy_to(vector<uint32_t> &out) const;
+
+    /* static void visit(const node &n, const function<void(const node &)> &f);
+     Calls f with every leaf under n, in order.
+     */
+    static void visit(const node &n, const function<void(const node &)> &f);
+
+public:
+
+/******************************************************************************
+     ID sequence constructor
+******************************************************************************/
+
+    /* id_sequence();
+     Default constructor for ID sequence class.
+        @post       Sequence is empty.
+     */
+    id_sequence();
+
+    /* id_sequence(const id_sequence &other);
+     Copy constructor. Shares every leaf and node of other, in constant time.
+        @post       Sequence holds the same IDs as other. Changing either
+                    leaves the other as it is.
+     */
+    id_sequence(const id_sequence &other);
+
+    /* id_sequence &operator=(const id_sequence &other);
+     Shares every leaf and node of other, in constant time, like the copy
+     constructor.
+     */
+    id_sequence &operator=(const id_sequence &other);
+
+    // Moving a sequence takes its index along with its leaves and nodes
+    id_sequence(id_sequence &&other) = default;
+    id_sequence &operator=(id_sequence &&other) = default;
+
+/******************************************************************************
+     Changing the sequence
+******************************************************************************/
+
+    /* void insert(size_t pos, uint32_t id);
+     Adds id at position pos, counting from 0. IDs from pos on move one
+     position up.
+        @pre        pos <= size().
+     */
+    void insert(size_t pos, uint32_t id);
+
+    /* uint32_t erase(size_t pos);
+     Takes ID at position pos out of the sequence and returns it. IDs after
+     pos move one position down.
+        @pre        pos < size().
+     */
+    uint32_t erase(size_t pos);
+
+    /* size_t erase_all(uint32_t id);
+     Takes every copy of id out of the sequence, in time proportional to the
+     number of leaves holding it times the depth of the tree. Other IDs keep
+     their order.
+        @return     size_t  [out] number of copies taken out
+     */
+    size_t erase_all(uint32_t id);
+
+    /* void insert(size_t pos, const vector<uint32_t> &ids);
+     Adds ids, in order, at position pos, counting from 0. IDs from pos on
+     move ids.size() positions up. A few ids are added one at a time; more
+     are put in with the rest of the sequence in one pass, in time linear in
+     size() + ids.size().
+        @pre        pos <= size().
+     */
+    void insert(size_t pos, const vector<uint32_t> &ids);
+
+    /* size_t erase_all(const vector<uint32_t> &ids);
+     Takes every copy of every ID in ids out of the sequence. A few copies are
+     taken out a leaf at a time like erase_all(id); more are left out of the
+     rest of the sequence in one pass, in time linear in size(). Other IDs
+     keep their order.
+        @return     size_t  [out] number of copies taken out
+     */
+    size_t erase_all(const vector<uint32_t> &ids);
+
+    /* void assign(const vector<uint32_t> &ids);
+     Replaces whole sequence with ids, in order, in time linear in the
+     number of ids.
+     */
+    void assign(const vector<uint32_t> &ids);
+
+/******************************************************************************
+     Reading the sequence
+******************************************************************************/
+
+    /* uint32_t at(size_t pos) const;
+     Returns ID at position pos, counting from 0.
+        @pre        pos < size().
+     */
+    uint32_t at(size_t pos) const;
+
+    /* size_t count(uint32_t id) const;
+     Returns number of copies of id in the sequence, without reading it once
+     the index is built.
+     */
+    size_t count(uint32_t id) const;
+
+    /* size_t size() const;
+     Returns number of IDs in the sequence.
+     */
+    size_t size() const;
+
+    /* void for_each_run(const function<void(const uint32_t *, size_t)> &f)
+            const;
+     Calls f(ids, n) for runs of n IDs next to each other in the sequence,
+     from first to last, so every ID is read in order.
+     */
+    void for_each_run(const function<void(const uint32_t *, size_t)> &f) const;
+
+};
+
+#endif
@@ -21,7 +21,12 @@
                     the program's working directory is used.)
  
  Build with     : g++ -o jukebox main.cpp menu.cpp song.cpp playlist.cpp
-                    playlist_database.cpp song_database.cpp
+                    playlist_database.cpp song_database.cpp mapped_file.cpp
+                    row_tokenizer.cpp string_dictionary.cpp
+                    trigram_index.cpp folded_column.cpp fuzzy_index.cpp
+                    prefix_index.cpp song_query.cpp sorted_index.cpp
+                    search_cache.cpp song_writer.cpp id_sequence.cpp
+                    -pthread
  
  Last modified  : October 26, 2014
  
@@ -43,14 +48,10 @@ using namespace std;
 
 int main(int argc, const char * argv[]){
     
-    // File streams so we can read from file to populate song database
-    // and write to file to save playists
-    ifstream readf;
+    // File stream so we can write to file to save playists
+    // Song database maps its file into memory, so needs no stream to read it
     ofstream writef;
     
-    // New, empty playlist database
-    playlist_database pDb (writef);
-    
     // Name of file to read from
     string fName;
    
@@ -61,7 +62,12 @@ int main(int argc, const char * argv[]){
         fName = argv[1];
         
         // Create new song database with data from file
-        song_database sDb(readf, fName);
+        // Load it from its snapshot, or parse it in the background
+        song_database sDb(fName, 0, true, true);
+        sDb.use_search_index();
+        
+        // New, empty playlist database, holding song IDs of songs in sDb
+        playlist_database pDb (writef, sDb);
         
         // Create new user menu using song database newly created from file
         // and new empty playlist database
@@ -74,7 +80,11 @@ int main(int argc, const char * argv[]){
         
         // No file name given. Create new song database with default file
         // songs.csv in working directory of program
-        song_database sDb(readf);
+        song_database sDb(string("songs.csv"), 0, true, true);
+        sDb.use_search_index();
+        
+        // New, empty playlist database, holding song IDs of songs in sDb
+        playlist_database pDb (writef, sDb);
         
         // Create new user menu using song database newly created from file
         // and new empty playlist database
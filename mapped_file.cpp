@@ -0,0 +1,80 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Default constructor. Nothing is mapped. */
+mapped_file::mapped_file(): data(NULL), length(0) {}
+
+/* Destructor. Releases mapping. */
+mapped_file::~mapped_file() { close(); }
+
+/* Opens file fName, finds its size and maps the whole file read-only. The file
+    descriptor is closed straight after mapping as the mapping keeps the file
+    contents alive on its own. Empty files cannot be mapped, so are treated as
+    successfully opened files of length 0.
+ */
+bool mapped_file::open(const string &fName) {
+    
+    close();
+    
+    int fd = ::open(fName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    // Nothing to map
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+    
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    
+    // File is read front to back exactly once while loading
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    
+    data = static_cast<const char *>(p);
+    length = st.st_size;
+    
+    return true;
+}
+
+/* Unmaps file if one is mapped */
+void mapped_file::close() {
+    if (data != NULL) {
+        munmap(const_cast<char *>(data), length);
+    }
+    data = NULL;
+    length = 0;
+}
+
+/* Exchanges mappings with other */
+void mapped_file::swap(mapped_file &other) {
+    std::swap(data, other.data);
+    std::swap(length, other.length);
+}
+
+/* Returns first byte of mapped file */
+const char *mapped_file::begin() const { return data; }
+
+/* Returns one past the last byte of mapped file */
+const char *mapped_file::end() const { return data + length; }
+
+/* Returns number of bytes mapped */
+size_t mapped_file::size() const { return length; }
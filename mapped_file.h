@@ -0,0 +1,93 @@
+/*****************************************************************************
+ Title:       mapped_file.h
+ Description: Mapped File Class Definition (Header File)
+
+ A read-only, memory-mapped view of a file on disk.
+ - Maps the whole file into memory so it can be scanned in place without
+ copying it through a stream buffer.
+ - Unmaps the file when closed or destroyed. Anything pointing into the mapping
+ must not outlive it.
+
+ *****************************************************************************/
+
+#ifndef ___mapped_file__
+#define ___mapped_file__
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+class mapped_file {
+    
+    // Start of mapped file contents. NULL if nothing is mapped.
+    const char *data;
+    
+    // Number of bytes mapped
+    size_t length;
+    
+public:
+    
+/******************************************************************************
+     Mapped file constructor / destructor
+******************************************************************************/
+    
+    /* mapped_file();
+     Default constructor for mapped file class. Nothing is mapped.
+        @post       data is NULL and length is 0.
+     */
+    mapped_file();
+    
+    /* ~mapped_file();
+     Destructor for mapped file class. Unmaps file if one is mapped.
+     */
+    ~mapped_file();
+    
+    // A mapping has exactly one owner
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator = (const mapped_file &) = delete;
+    
+/******************************************************************************
+     Mapping and unmapping files
+******************************************************************************/
+    
+    /* bool open(const string &fName);
+     Maps the whole of file fName read-only into memory.
+        @param      string &fName   [in] path & name of file to map
+        @return     bool            [out] returns true if file was opened and
+                                    mapped, else returns false.
+        @pre        fName is an initialized, non-empty string.
+        @post       If successful, any previous mapping is released and data
+                    points to the first of length bytes of file fName. An empty
+                    file is opened successfully with length 0. If unsuccessful,
+                    nothing is mapped.
+     */
+    bool open(const string &fName);
+    
+    /* void close();
+     Unmaps file if one is mapped.
+        @post       data is NULL and length is 0.
+     */
+    void close();
+    
+    /* void swap(mapped_file &other);
+     Exchanges mappings with other. Nothing is unmapped or remapped, so
+     anything pointing into either mapping stays valid.
+     */
+    void swap(mapped_file &other);
+    
+/******************************************************************************
+     Returning mapped file variables / characteristics
+******************************************************************************/
+    
+    /* const char *begin() const; const char *end() const; size_t size() const;
+     Returns the first byte, one past the last byte and the number of bytes of
+     the mapped file.
+     */
+    const char *begin() const;
+    const char *end() const;
+    size_t size() const;
+    
+};
+
+#endif
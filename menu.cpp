@@ -1,7 +1,7 @@
 #include "menu.h"
 
 /*Default Constructor for menu class. Initializes member variables depending on passed parameters and displays menu upon class construction. */
-menu::menu(playlist_database &p, const song_database &s, ostream &o, istream &i, ostream &e): pDb(p), sDb(s), os(o), is(i), err(e) {
+menu::menu(playlist_database &p, song_database &s, ostream &o, istream &i, ostream &e): pDb(p), sDb(s), os(o), is(i), err(e), page_size(0), page_first(0), page_last(0), page_after(0) {
     display_menu();
 }
 
@@ -21,6 +21,10 @@ void menu::get_command() {
     string user_input;
     getline(is, user_input);
     
+    // Report a progressive load stopped by an invalid line here, on the
+    // thread running the menu, rather than exiting from the loader
+    sDb.load_failed(err);
+    
     // Breaks up user input line using stringstream
     // First word is cmd, second is key1 and rest of line is key 2
     // First word, key1 and key2 are separated by spaces
@@ -49,6 +53,45 @@ bool menu::string_to_int(string s, int &id){
     return true;
 }
 
+/* Reads s a comma separated part at a time. Each part is a song ID or two
+    song IDs with a dash between them, the first no bigger than the second.
+    Every song ID is checked with is_valid_sID before a range is expanded, so
+    a mistyped range can't list more songs than are in the database.
+ */
+bool menu::string_to_ids(string s, vector<uint32_t> &ids){
+    
+    istringstream parts(s);
+    string part;
+    while (getline(parts, part, ',')) {
+        
+        int first, last;
+        char dash;
+        istringstream ss(part);
+        if (!(ss >> first)) {
+            err << "Sorry, there was an error with your command. Please check that you are entering song IDs like 3,8,20-40 and try again .\n" << endl;
+            return false;
+        }
+        if (ss >> dash) {
+            if (dash != '-' || !(ss >> last) || first > last) {
+                err << "Sorry, there was an error with your command. Please check that you are entering song IDs like 3,8,20-40 and try again .\n" << endl;
+                return false;
+            }
+        }
+        else {
+            last = first;
+        }
+        
+        if (!is_valid_sID(first) || !is_valid_sID(last)) {
+            return false;
+        }
+        for (int sID=first; sID<=last; sID++) {
+            ids.push_back((uint32_t)sID);
+        }
+    }
+    
+    return true;
+}
+
 /* Checks to see if sID is a valid song ID, i.e. if it is greater or equal to 
  one and less than or equal to the number of songs in the song database. 
  If sID is NOT valid, writes an error message to the error stream and returns
@@ -61,6 +104,32 @@ bool menu::is_valid_sID(int sID) {
     return true;
 }
 
+/* Runs the last L, A or T command for songs after page_after, skipping skip
+    songs first, and displays at most page_size of them, or every song if
+    page_size is 0. If there are more songs after them, tells user how to see
+    them. Returns number of songs displayed.
+ */
+int menu::show_page(int skip) {
+    size_t limit = page_size > 0 ? (size_t)page_size : SIZE_MAX;
+    
+    int count;
+    if (page_cmd == "l") {
+        count = sDb.list_songs(page_first, page_last, skip, limit, page_after);
+    }
+    else if (page_cmd == "a") {
+        count = sDb.display_songs_by_artist(page_key, skip, limit, page_after);
+    }
+    else {
+        count = sDb.display_songs_by_title(page_key, skip, limit, page_after);
+    }
+    
+    if (page_after != 0) {
+        os << "(There are more songs after song ID " << page_after << ". Enter More to see the next " << page_size << ".)" << endl;
+    }
+    
+    return count;
+}
+
 /* Handles actions based on value of cmd while in the top level user menu
     Checks user inputs for validity and decides which functions based on 
     results of validity checks and value of cmd.
@@ -81,6 +150,12 @@ void menu::handle_menu_command(){
             return display_help_menu();
         }
         
+        // Reload songs file and redisplay menu. Playlists are kept.
+        else if (cmd == "r") {
+            sDb.reload(err);
+            return display_menu();
+        }
+        
         // Exit program with no errors
         else if (cmd == "q") {
             err << "Exiting the program. Good bye!" << endl;
@@ -123,7 +198,7 @@ void menu::handle_menu_command(){
             
             // Playlist exists. Display songs in playlist and redisplay menu
             else {
-                pDb.display_playlist(os,pID);
+                pDb.display_playlist(os, pID, sDb.get_output_format());
                 return display_menu();
             }
             
@@ -264,8 +339,12 @@ void menu::handle_playlist_mod_command() {
         }
 
         // Lists songs in database from song ID first to song ID last
-        // in ascending order
-        sDb.list_songs(first, last);
+        // in ascending order, a page at a time if pages are set
+        page_cmd = cmd;
+        page_first = first;
+        page_last = last;
+        page_after = 0;
+        show_page(0);
         
         // Redisplay menu
         return display_playlist_mod_menu();
@@ -276,8 +355,12 @@ void menu::handle_playlist_mod_command() {
     else if (cmd =="a") {
         
         // Search through song database, display songs containing key1
-        // as substring of artist field. Return how many songs were found
-        int count = sDb.display_songs_by_artist(key1);
+        // as substring of artist field, a page at a time if pages are set.
+        // Return how many songs were displayed
+        page_cmd = cmd;
+        page_key = key1;
+        page_after = 0;
+        int count = show_page(0);
         
         // If key was not found a substring of the artist field for any song in
         // the song database
@@ -293,8 +376,12 @@ void menu::handle_playlist_mod_command() {
     else if (cmd =="t") {
         
         // Search through song database, display songs containing key1
-        // as substring of title field. Return how many songs were found
-        int count = sDb.display_songs_by_title(key1);
+        // as substring of title field, a page at a time if pages are set.
+        // Return how many songs were displayed
+        page_cmd = cmd;
+        page_key = key1;
+        page_after = 0;
+        int count = show_page(0);
         
         // If key was not found as substring of title field for any song in
         // the song database
@@ -306,6 +393,194 @@ void menu::handle_playlist_mod_command() {
         return display_playlist_mod_menu();
     }
     
+    // Set how many songs L, A and T display at a time
+    else if (cmd =="page") {
+        
+        // If conversion to integer is unsuccessful or size is negative,
+        // prompts user to try again
+        int size;
+        if (!string_to_int(key1, size)) {
+            return display_playlist_mod_menu();
+        }
+        if (size < 0) {
+            err << "ERROR: Page size can't be negative. Please try again.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        page_size = size;
+        if (page_size == 0) {
+            os << "Songs will all be shown at once." << endl;
+        }
+        else {
+            os << "Songs will be shown " << page_size << " at a time." << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
+    // Set how songs are written: text, tsv or json
+    else if (cmd =="format") {
+        
+        // If format is unknown, prompts user to try again
+        output_format f;
+        if (!song_writer::parse_format(key1, f)) {
+            err << "ERROR: '" << key1 << "' isn't a format. Please enter text, tsv or json.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        sDb.use_output_format(f);
+        os << "Songs will be shown as " << (f == OUTPUT_TEXT ? "text" : f == OUTPUT_TSV ? "tab separated values" : "JSON Lines") << "." << endl;
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
+    // Display next page of songs from the last L, A or T
+    else if (cmd =="more") {
+        
+        // If the last listing or search was shown in full, there is nothing
+        // more to show
+        if (page_after == 0) {
+            err << "ERROR: There are no more songs to show. Please list or search for songs first.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        // Songs to skip, if any. If conversion to integer is unsuccessful or
+        // number is negative, prompts user to try again
+        int skip = 0;
+        if (!key1.empty() && !string_to_int(key1, skip)) {
+            return display_playlist_mod_menu();
+        }
+        if (skip < 0) {
+            err << "ERROR: Number of songs to skip can't be negative. Please try again.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        if (show_page(skip) == 0) {
+            os << "There were no more songs." << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }    
+    // Display artists and titles closest to key, allowing for typos
+    else if (cmd =="f") {
+        
+        // Key may be more than one word
+        string key = key2.empty() ? key1 : key1 + " " + key2;
+        
+        // Search through song database, display closest artists and titles.
+        // Return how many were found
+        int count = sDb.display_closest(key, FUZZY_RESULTS);
+        
+        // If nothing was close to key
+        if (count == 0) {
+            os << "There were no artists or titles close to '" << key << "'." << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }    
+    // Display artists and titles starting with key
+    else if (cmd =="p") {
+        
+        // Prefix may be more than one word
+        string prefix = key2.empty() ? key1 : key1 + " " + key2;
+        
+        // Search through song database, display artists and titles starting
+        // with prefix. Return how many were found
+        int count = sDb.display_completions(prefix, COMPLETIONS);
+        
+        // If nothing starts with prefix
+        if (count == 0) {
+            os << "There were no artists or titles starting with '" << prefix << "'." << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }    
+    // Display songs matching a query over several fields
+    else if (cmd =="query") {
+        
+        // Query is the rest of the line
+        string text = key2.empty() ? key1 : key1 + " " + key2;
+        
+        // If query can't be understood, displays what couldn't be.
+        // Prompts user to try again
+        song_query q;
+        if (!q.parse(text, err)) {
+            return display_playlist_mod_menu();
+        }
+        if (q.size() == 0) {
+            err << "ERROR: Query has no terms. Please try again.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        // Search through song database, display songs matching every term.
+        // Return how many songs were found
+        int count = sDb.display_query(q);
+        
+        // If no song matched
+        if (count == 0) {
+            os << "There were no songs matching '" << text << "'." << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }    
+    // Display how often searches were answered from the search cache
+    else if (cmd =="stats") {
+        sDb.display_cache_stats();
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }    
+    
+    // Insert a list of songs into the playlist, like 3,8,20-40
+    else if (cmd =="insert" && key1.find_first_of(",-", 1) != string::npos) {
+        
+        // If list or position can't be converted, or lists a song ID that
+        // is invalid, prompts user to try again
+        vector<uint32_t> sIDs;
+        int pos;
+        if (!string_to_ids(key1, sIDs) || !string_to_int(key2, pos)) {
+            return display_playlist_mod_menu();
+        }
+        
+        // Insert every song at once, starting at position pos
+        return insert_songs(sIDs, pos);
+    }
+    
+    // Insert every song from the last L, A or T into the playlist
+    else if (cmd =="insertall") {
+        
+        int pos;
+        if (!string_to_int(key1, pos)) {
+            return display_playlist_mod_menu();
+        }
+        
+        // Songs L listed, or A or T found, in the same order
+        vector<uint32_t> sIDs;
+        if (page_cmd == "l") {
+            int last = page_last < sDb.size() ? page_last : sDb.size();
+            for (int sID=page_first < 1 ? 1 : page_first; sID<=last; sID++) {
+                sIDs.push_back((uint32_t)sID);
+            }
+        }
+        else if (page_cmd == "a") {
+            sDb.find_songs(QUERY_ARTIST, page_key, sIDs);
+        }
+        else if (page_cmd == "t") {
+            sDb.find_songs(QUERY_TITLE, page_key, sIDs);
+        }
+        else {
+            err << "ERROR: There are no songs to insert yet. Please list or search for songs with L, A or T first.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        return insert_songs(sIDs, pos);
+    }
     
     // Insert a song into the playlist
     else if (cmd =="insert") {
@@ -323,19 +598,20 @@ void menu::handle_playlist_mod_command() {
             return display_playlist_mod_menu();
         }
         
-        // Song ID is valid. Copy song with song ID sID from database into s
-        song s = sDb.get_song(sID);
+        // Song ID is valid. Get song with song ID sID from database as s. Its
+        // text is not copied.
+        const song s = sDb.get_song(sID);
         
         // Attempt to insert song into playlist pID at position pos
         // If insertion was unsuccesful, display error and propt user
         // to try again.
         if (!pDb.insert_song_into_playlist(pID, s, pos)) {
-            err << "There was an error inserting your song '" << sDb.get_song(sID).get_title() << "' into the playlist. \n Please try again. \n" << endl;
+            err << "There was an error inserting your song '" << s.get_title() << "' into the playlist. \n Please try again. \n" << endl;
         }
         else {
             // Insertion was successful. Display success message indicating
             // where the song was inserted (beginning, end or at position pos)
-            os << "Success! Your song '" << sDb.get_song(sID).get_title() << "' was inserted into playlist '" << pDb.get_playlist_name(pID) ;
+            os << "Success! Your song '" << s.get_title() << "' was inserted into playlist '" << pDb.get_playlist_name(pID) ;
             if (pos <=1) {
                 os << "' at the beginning of the list";
             }
@@ -353,6 +629,34 @@ void menu::handle_playlist_mod_command() {
         return display_playlist_mod_menu();
     }
     
+    // Delete a list of songs from playlist, like 3,8,20-40
+    else if (cmd =="delete" && key1.find_first_of(",-", 1) != string::npos) {
+        
+        // If list can't be converted, or lists a song ID that is invalid,
+        // prompts user to try again
+        vector<uint32_t> sIDs;
+        if (!string_to_ids(key1, sIDs)) {
+            return display_playlist_mod_menu();
+        }
+        
+        // Delete every instance of every song at once
+        // Return number of songs deleted
+        int deletions = pDb.delete_songs_from_playlist(pID, sIDs);
+        
+        if (deletions < 0) { // If deletions == -1, playlist was empty
+            err << "Your playlist is empty. No deletions were made. \n" << endl;
+        }
+        else if (deletions == 0){ // No deletions made
+            err << "Your playlist does not contain any of those songs. No deletions were made. \n" << endl;
+        }
+        else { // 1 or more deletions made successfully
+            os << "Success! " << deletions << " songs were deleted from playlist '" << pDb.get_playlist_name(pID) <<"'.\n" << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
     // Delete song from playlist
     else if (cmd =="delete") {
         
@@ -388,10 +692,95 @@ void menu::handle_playlist_mod_command() {
         return display_playlist_mod_menu();
     }
     
+    // Display how many times a song is in the playlist
+    else if (cmd =="count") {
+        
+        // Convert user input from string to integer
+        // If conversion to integer is unsuccessful, prompts user to try again
+        int sID;
+        if (!string_to_int(key1, sID)){
+            return display_playlist_mod_menu();
+        }
+        
+        // If song ID is invalid and not a song ID in the song database,
+        // Display invalid song id error and prompt user to try gain
+        if (!is_valid_sID(sID)) {
+            return display_playlist_mod_menu();
+        }
+        
+        int copies = pDb.count_song_in_playlist(pID, sID);
+        os << "Your song '" << sDb.get_song(sID).get_title() << "' is in playlist '" << pDb.get_playlist_name(pID) << "' " << copies << (copies == 1 ? " time" : " times") << ".\n" << endl;
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
+    // Clone playlist as new playlist, and edit clone
+    else if (cmd =="clone") {
+        
+        // Name can include spaces, so concatenate key1 and key2
+        string cName;
+        if (!key2.empty()){
+            cName = key1 + ' ' + key2;
+        }
+        else {
+            cName = key1;
+        }
+        
+        // Clone must have a name no other playlist has
+        if (cName.empty()) {
+            err << "ERROR: Please enter a name for your clone and try again.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        if (pDb.is_existing_playlist(cName) >= 0) {
+            err << "Sorry, the playlist '" << cName << "' already exists. \n Playlist names are not case sensitive. Please try again.\n" << endl;
+            return display_playlist_mod_menu();
+        }
+        
+        // Clone is added as last playlist in database. Edit clone from now on.
+        string pName = pDb.get_playlist_name(pID);
+        pDb.clone_playlist(pID, cName);
+        pID = (int)pDb.size() - 1;
+        os << "Success! Playlist '" << pName << "' was cloned as '" << cName << "'. You are now editing '" << cName << "'.\n" << endl;
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
+    // Undo last change made to songs in any playlist
+    else if (cmd =="undo") {
+        
+        int changed;
+        if (!pDb.undo(changed)) {
+            err << "ERROR: There are no changes to undo.\n" << endl;
+        }
+        else {
+            os << "Success! Your last change to playlist '" << pDb.get_playlist_name(changed) << "' was undone.\n" << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
+    // Make last change undone again
+    else if (cmd =="redo") {
+        
+        int changed;
+        if (!pDb.redo(changed)) {
+            err << "ERROR: There are no changes to redo.\n" << endl;
+        }
+        else {
+            os << "Success! Your change to playlist '" << pDb.get_playlist_name(changed) << "' was redone.\n" << endl;
+        }
+        
+        // Redisplay menu
+        return display_playlist_mod_menu();
+    }
+    
     // Display all songs in playlist
     else if (cmd =="show") {
         
-        pDb.display_playlist(os, pID);
+        pDb.display_playlist(os, pID, sDb.get_output_format());
         
         // Redisplay menu
         return display_playlist_mod_menu();
@@ -428,6 +817,7 @@ void menu::display_menu(){
     os << "[M/m] <playlist>  Modify an playlist" << endl;
     os << "[D/d] <playlist>  Delete an existing playlist" << endl;
     os << "[S/s] <filename>  Save all the playlists" << endl;
+    os << "[R/r]             Reload the songs file" << endl;
     os << "[H/h]             Help" << endl;
     os << "[Q/q]             Exit \n" << endl;
     os << "ENTER COMMAND: " ;
@@ -437,6 +827,41 @@ void menu::display_menu(){
 }
 
 
+/* Inserts sIDs into the playlist and tells user how many were inserted and
+    where, then redisplays playlist modification mode menu.
+ */
+void menu::insert_songs(const vector<uint32_t> &sIDs, int pos) {
+    
+    if (sIDs.empty()) {
+        err << "There were no songs to insert. No insertions were made. \n" << endl;
+        return display_playlist_mod_menu();
+    }
+    
+    // Where songs will go, as the success message puts it
+    bool at_end = pos > 1 && pos > pDb.get_playlist_size(pID);
+    
+    if (!pDb.insert_songs_into_playlist(pID, sIDs, pos)) {
+        err << "There was an error inserting your songs into the playlist. \n Please try again. \n" << endl;
+    }
+    else {
+        os << "Success! " << sIDs.size() << " songs were inserted into playlist '" << pDb.get_playlist_name(pID);
+        if (pos <= 1) {
+            os << "' at the beginning of the list";
+        }
+        else if (at_end) {
+            os << "' at the end of the list";
+        }
+        else {
+            os << "' at position " << pos;
+        }
+        os << ".\n" << endl;
+    }
+    
+    // Redisplay menu
+    return display_playlist_mod_menu();
+}
+
+
 /* Displays playlist modification mode menu, calls functions to clear commands, get user user inputs and handle actions based on user input */
 void menu::display_playlist_mod_menu(){
 
@@ -450,8 +875,20 @@ void menu::display_playlist_mod_menu(){
     os << "[L/l] <first><last>    List songs from database from first to last" << endl;
     os << "[A/a] <artist_key>     List all songs whose artist contains artist_key as a substring" << endl;
     os << "[T/t] <title_key>      List all songs whose title contains title_key as a substring" << endl;
+    os << "[F/f] <key>            List artists and titles closest to key, allowing typos" << endl;
+    os << "[P/p] <prefix>         List artists and titles starting with prefix" << endl;
+    os << "Query <terms>          List all songs matching every term, e.g. year:1990..1999" << endl;
+    os << "Stats                  Show how often searches were answered from the search cache" << endl;
+    os << "Page <size>            Show at most size songs at a time for L, A and T (0 for all)" << endl;
+    os << "More [<skip>]          Show the next page of songs, skipping skip songs first" << endl;
+    os << "Format <format>        Show songs as text, tsv or json" << endl;
     os << "Insert <songid> <pos>  Insert the songid into playlist at position <pos>" << endl;
+    os << "Insertall <pos>        Insert every song from the last L, A or T at position <pos>" << endl;
     os << "Delete <songid>        Delete songid from playlist" << endl;
+    os << "Count <songid>         Show how many times songid is in playlist" << endl;
+    os << "Clone <playlist>       Clone playlist as a new playlist and edit the clone" << endl;
+    os << "Undo                   Undo the last change to a playlist" << endl;
+    os << "Redo                   Redo the last change undone" << endl;
     os << "Show                   Display songs in the playlist" << endl;
     os << "[B/b]                  Return to top level user menu\n" << endl;
     os << "ENTER COMMAND: " ;
@@ -497,6 +934,11 @@ void menu::display_help_menu(){
 
     os << "[S/s] <filename>  Save all your playlists to a file named <filename>.\n" << endl;
 
+    os << "[R/r]             Reloads the songs file if it has changed. Only new or" << endl;
+    os << "                  changed songs are read again, and your playlists are" << endl;
+    os << "                  kept. Songs keep their song ID if their line in the" << endl;
+    os << "                  file didn't move.\n" << endl;
+
     os << "[H/h]             Displays this help menu you're looking at now!\n" << endl;
 
     os << "[Q/q]             Exits the program. \n" << endl;
@@ -524,13 +966,79 @@ void menu::display_help_menu(){
     os << "                       as part of their name. Title keys and names are NOT" << endl;
     os << "                       case sensitive.\n" << endl;
 
+    os << "[F/f] <key>            Not sure how it's spelled? This will print out the" << endl;
+    os << "                       artists and song titles closest to <key>, even if" << endl;
+    os << "                       <key> has a few typos in it, closest first, along" << endl;
+    os << "                       with the songs that have those titles. Keys are NOT" << endl;
+    os << "                       case sensitive.\n" << endl;
+
+    os << "[P/p] <prefix>         Only know how it starts? This will print out the" << endl;
+    os << "                       first artists and song titles, in alphabetical" << endl;
+    os << "                       order, that start with <prefix>. Prefixes are NOT" << endl;
+    os << "                       case sensitive.\n" << endl;
+
+    os << "Query <terms>          Looking for something more specific? This will print" << endl;
+    os << "                       out a list of songs that match every one of <terms>," << endl;
+    os << "                       for example:" << endl;
+    os << "                         query artist:beatles year:1965..1970 time<240" << endl;
+    os << "                       title, artist, album, genre and comments terms match" << endl;
+    os << "                       songs containing their key, which is NOT case" << endl;
+    os << "                       sensitive. Put keys with spaces in double quotes." << endl;
+    os << "                       size, time and year terms take a number, a range" << endl;
+    os << "                       like 1990..1999 (either end may be left out), or" << endl;
+    os << "                       <, <=, > or >= a number. Times are in seconds or" << endl;
+    os << "                       minutes:seconds.\n" << endl;
+
+    os << "Stats                  Artist and title searches you repeat are answered" << endl;
+    os << "                       straight away from a cache of recent results. This" << endl;
+    os << "                       shows how many searches were, and how full the" << endl;
+    os << "                       cache is. The cache is emptied when you reload.\n" << endl;
+
+    os << "Page <size>            Too many songs to read? After this, L, A and T show" << endl;
+    os << "                       at most <size> songs at a time. Page 0 goes back to" << endl;
+    os << "                       showing every song at once.\n" << endl;
+
+    os << "More [<skip>]          Shows the next page of songs from your last L, A or" << endl;
+    os << "                       T. If you give <skip>, that many songs are skipped" << endl;
+    os << "                       before the page starts.\n" << endl;
+
+    os << "Format <format>        Want songs another program can read? Format tsv" << endl;
+    os << "                       shows each song on one line, its fields separated" << endl;
+    os << "                       by tabs: ID, title, artist, album, genre, size, time" << endl;
+    os << "                       in seconds, year and comments. Format json shows" << endl;
+    os << "                       each song as a JSON object on one line. Format text" << endl;
+    os << "                       goes back to columns. Songs in playlists you show" << endl;
+    os << "                       or view are shown the same way.\n" << endl;
+
     os << "Insert <songid> <pos>  Insert a song with the song ID <songid> into your" << endl;
-    os << "                       playlist at position number <pos>\n" << endl;
+    os << "                       playlist at position number <pos>. <songid> can" << endl;
+    os << "                       also be a list of song IDs and ranges of song IDs," << endl;
+    os << "                       like 3,8,20-40, to insert them all, in that order.\n" << endl;
+
+    os << "Insertall <pos>        Insert every song your last L, A or T listed or" << endl;
+    os << "                       found, not just the page shown, into your playlist" << endl;
+    os << "                       at position number <pos>, in the same order.\n" << endl;
 
     os << "Delete <songid>        Delete a song with the song ID <songid> from your" << endl;
     os << "                       playlist. Be careful, if your song appears more"<< endl;
     os << "                       than once... it will get deleted everywhere" << endl;
-    os << "                       it appears!\n" << endl;
+    os << "                       it appears! <songid> can also be a list of song" << endl;
+    os << "                       IDs and ranges of song IDs, like 3,8,20-40, to" << endl;
+    os << "                       delete them all.\n" << endl;
+
+    os << "Count <songid>         Shows how many times the song with the song ID" << endl;
+    os << "                       <songid> is in your playlist.\n" << endl;
+
+    os << "Clone <playlist>       Create a new playlist named <playlist> holding" << endl;
+    os << "                       the same songs as your playlist, in the same" << endl;
+    os << "                       order, and edit the new playlist from then on.\n" << endl;
+
+    os << "Undo                   Undo the last insert or delete made to any of" << endl;
+    os << "                       your playlists. Up to " << playlist_database::HISTORY_MAX << " changes can be undone," << endl;
+    os << "                       one at a time.\n" << endl;
+
+    os << "Redo                   Make the last change you undid again. Changes" << endl;
+    os << "                       can no longer be redone once you make another.\n" << endl;
 
     os << "Show                   Display all the songs in your playlist.\n" << endl;
     
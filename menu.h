@@ -39,9 +39,26 @@ class menu {
     // Playlist to edit
     int pID;
     
+    // Number of songs L, A and T display at a time, 0 for every song
+    int page_size;
+    
+    // Last L, A or T command and its inputs, and song ID of the last song
+    // it displayed if there are more, so More can display the next page
+    string page_cmd;
+    string page_key;
+    int page_first;
+    int page_last;
+    int page_after;
+    
+    // Most artists, and most titles, a fuzzy search displays
+    static const int FUZZY_RESULTS = 10;
+    
+    // Most artists, and most titles, a completion displays
+    static const int COMPLETIONS = 10;
+    
     // Databases to store/get information
     playlist_database &pDb;
-    const song_database &sDb;
+    song_database &sDb;
     
 public:
 
@@ -49,14 +66,14 @@ public:
      Menu constructor
 ******************************************************************************/
     
-    /* menu(playlist_database &p, const song_database &s, ostream &o = cout,
+    /* menu(playlist_database &p, song_database &s, ostream &o = cout,
         istream &i = cin, ostream &e = cerr);
      Default constructor for menu class.
         @param      playlist_database &p    [in/out] playlist database to 
                                             create/modify/read existing playlist 
                                             data
-        @param      const song_database &s  [in] song database to read song
-                                            data from
+        @param      song_database &s  [in/out] song database to read song
+                                            data from and reload
         @param      ostream &o      [in/out] stream to display prompt to console
         @param      istream &i      [in] stream to get user input from
         @param      ostream &err    [in/out] stream to display errors to console
@@ -65,7 +82,7 @@ public:
         @post       menu is initialized where &pDb = &p, &sDb = &s, &os = &o, 
                     &is = &i, &err = &e. All other member variables are empty
      */
-    menu(playlist_database &p, const song_database &s, ostream &o = cout, istream &i = cin, ostream &e = cerr);
+    menu(playlist_database &p, song_database &s, ostream &o = cout, istream &i = cin, ostream &e = cerr);
     
     
 /******************************************************************************
@@ -92,6 +109,19 @@ public:
      */
     void clear_command();
 
+    /* int show_page(int skip);
+     Displays the next page of songs from the last L, A or T command.
+        @param      int skip    [in] number of songs to skip first
+        @return     int         [out] number of songs displayed
+        @pre        page_cmd is l, a or t.
+        @post       Up to page_size songs after song ID page_after, or every
+                    song if page_size is 0, are written to &os. page_after
+                    is the song ID of the last song written if there are
+                    more, else 0, and if there are more, how to see them is
+                    written to &os.
+     */
+    int show_page(int skip);
+    
     /* bool string_to_int(string s, int &id);
     Converts a variable of type string to type int
         @param      string s        [in] string to turn to int
@@ -108,6 +138,20 @@ public:
      */
     bool string_to_int(string s, int &id);
     
+    /* bool string_to_ids(string s, vector<uint32_t> &ids);
+    Converts a list of song IDs and ranges of song IDs, separated by commas,
+    like 3,8,20-40, to the song IDs it lists, in order.
+        @param      string s        [in] list to convert
+        @param      vector<uint32_t> &ids [out] song IDs listed, in order
+        @return     bool            [out] returns true if every song ID
+                                    listed is a song ID of a song in the song
+                                    database, else returns false
+        @pre        &err is open and initialized.
+        @post       If false is returned, an error message is written to &err
+                    and ids holds whatever was converted before the error.
+     */
+    bool string_to_ids(string s, vector<uint32_t> &ids);
+    
     /* bool is_valid_sID(int sID); 
     Checks if a given integer is the song ID of an existing song in the song
     database
@@ -149,6 +193,17 @@ public:
      */
     void display_playlist_mod_menu();
     
+    /* void insert_songs(const vector<uint32_t> &sIDs, int pos);
+     Inserts songs with song IDs sIDs, in order, into playlist pID at position
+     pos, writes how many were inserted and where, and redisplays playlist
+     modification mode menu.
+        @param      const vector<uint32_t> &sIDs [in] valid song IDs to insert
+        @param      int pos         [in] position to insert songs at
+        @pre        pID is a valid playlist ID. &os, &err are open.
+        @post       Songs are inserted, or an error is written to &err.
+     */
+    void insert_songs(const vector<uint32_t> &sIDs, int pos);
+    
     /* void display_help_menu();
     Displays help menu text.
      @pre        &os is  initialized and open.
@@ -176,6 +231,8 @@ public:
                     on inputs are called based on the value of cmd: 
                     cmd == l : Writes contents of pDb to &os stream
                     cmd == h : Diplays help menu
+                    cmd == r : Reloads song database from the songs file,
+                                parsing only songs that were added or changed
                     cmd == q : exits program with no errors
                         For the below values of cmd, pID gets the position in 
                     pDb of the playlist named key1. If such a playlist does not
@@ -210,6 +267,19 @@ public:
                                 a substring in the song artist
                     cmd == t : Display all songs in song database with key1 as
                                 a substring in the song title
+                    cmd == f : Display the FUZZY_RESULTS artists and titles in
+                                song database closest to key1 and key2,
+                                allowing for typos
+                    cmd == p : Display the first COMPLETIONS artists and
+                                titles in song database starting with key1
+                                and key2
+                    cmd == query : Display all songs in song database matching
+                                   every term of the query in key1 and key2
+                    cmd == stats : Display search cache statistics
+                    cmd == page : Set number of songs l, a and t display at a
+                                  time to key1
+                    cmd == more : Display next page of songs from the last l,
+                                  a or t, skipping key1 songs first
                     cmd == insert : Insert song with song ID matching key1 into
                                     playlist with id pID at position key2.
                     cmd == delete : Delete all songs with song ID matching key1
@@ -3,9 +3,18 @@
 
 /* Default Constructor
     Transforms given playlist name into all lowercase and saves in name_lower
-    Playlist_songs is an empty list
+    Playlist_songs is an empty sequence
  */
-playlist::playlist(string list_name): name(list_name) {
+playlist::playlist(string list_name, const song_database &s): name(list_name), songs(&s) {
+    name_lower = name;
+    transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
+}
+
+
+/* Clone constructor. Copying the sequence of song IDs shares it with
+    source. Name is lowercased as in the default constructor.
+ */
+playlist::playlist(const playlist &source, string list_name): name(list_name), playlist_songs(source.playlist_songs), songs(source.songs) {
     name_lower = name;
     transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
 }
@@ -24,52 +33,66 @@ size_t playlist::size() const { return playlist_songs.size(); }
 
 
 /* Returns true if playlist is empty, else returns false */
-bool playlist::is_empty() const{ return playlist_songs.empty(); }
+bool playlist::is_empty() const{ return playlist_songs.size() == 0; }
 
 
-/* Returns true if song s is inserted into playlist at position pos successfully. Else returns false. Performs checks to see if pos is valid. 
+/* Returns true if song sID is inserted into playlist at position pos successfully. Else returns false. Performs checks to see if pos is valid. 
     If pos <= 1 || pos > size(), changes value of pos so insertion can be
-    performed smoothly. Insertion is performed by using an iterator to advance
-    to the (pos-1)th position in the list, then using std::list::insert to 
-    insert song s after (pos-1)th element.
+    performed smoothly. Insertion is performed by id_sequence::insert, which
+    counts positions from 0, after (pos-1)th element.
  */
-bool playlist::insert (song s, int pos){
+bool playlist::insert (int sID, int pos){
     
-    // If pos <= 1, insert s to as the first element of the list
+    // If pos <= 1, insert sID to as the first element of the list
     if (pos <= 1) {
-        playlist_songs.push_front(s);
+        playlist_songs.insert(0, (uint32_t)sID);
         return true;
     }
     
-    // If pos > size, insert s as last element of list
-    else if (pos > size()) {
-        playlist_songs.push_back(s);
+    // If pos > size, insert sID as last element of list
+    else if ((size_t)pos > size()) {
+        playlist_songs.insert(size(), (uint32_t)sID);
         return true;
     }
     
-    // If 1 < pos <= size, insert s at position pos in list
+    // If 1 < pos <= size, insert sID at position pos in list, after
+    // (pos-1)th element
     else {
-        // Advance an iterator to (pos-1)th position
-        list<song>::iterator it = playlist_songs.begin();
-        advance(it, pos-1);
-        
-        // Inserts s after (pos-1)th element, so s is now (pos)th element in
-        // list
-        playlist_songs.insert(it, s);
-        
+        playlist_songs.insert(pos-1, (uint32_t)sID);
         return true;
-        
     }
     
     return false;
 }
 
+/* Clamps pos the same way insert does, then hands every song ID to
+    id_sequence::insert at once, which decides whether to insert them one at
+    a time or build the playlist again in one pass.
+ */
+bool playlist::insert_songs (const vector<uint32_t> &sIDs, int pos){
+    
+    size_t at = pos <= 1 ? 0 : (size_t)pos > size() ? size() : (size_t)(pos-1);
+    playlist_songs.insert(at, sIDs);
+    
+    return true;
+}
+
+/* Returns -1 if playlist is empty, else deletes every song ID in sIDs with
+    id_sequence::erase_all and returns how many songs were deleted.
+ */
+int playlist::delete_songs (const vector<uint32_t> &sIDs) {
+    
+    if (is_empty()) {
+        return -1;
+    }
+    return (int)playlist_songs.erase_all(sIDs);
+}
+
 /* Deletes all instances of songs that have song ID SID from playlist.
     Returns number of times a song was deleted from playlist. Returns -1 if 
     playlist is originally empty and so deletion could not be performed.
-    Performs deletion by using an iterator to iterate through the list. If 
-    iterator points to a song that has a song ID equal to sID, the song is 
-    deleted after the iterator increments.
+    Performs deletion with id_sequence::erase_all, which goes straight to the
+    parts of the playlist holding sID.
  */
 int playlist::delete_song(int sID) {
     
@@ -78,37 +101,19 @@ int playlist::delete_song(int sID) {
         return -1;
     }
     
-    // Playlist is non-empty
+    // Playlist is non-empty. Return number of times a deletion is performed
     else {
-        
-        // Number of times a deletion is performed
-        int count = 0;
-        
-        // Iterator starts at beginning of list
-        list<song>::iterator it = playlist_songs.begin();
-        
-        // While iterator is not at end of the list
-        while (it !=playlist_songs.end()){
-            
-            // If iterator is pointing to song that has a song ID of SID
-            // Increment iterator before deleting song, then delete song
-            // and add to deletion count
-            if ( (*it).get_id() == sID) {
-                playlist_songs.erase(it++);
-                count ++ ;
-            }
-            // Otherwise, advance iterator to next node
-            else {
-                it ++ ;
-            }
-                
-        }
-        
-        return count;
+        return (int)playlist_songs.erase_all((uint32_t)sID);
     }
 }
 
 
+/* Returns number of times song sID is in playlist, kept by id_sequence */
+int playlist::count_song(int sID) const {
+    return (int)playlist_songs.count((uint32_t)sID);
+}
+
+
 
 /* Writes the summary of a playlist to a file stream. Indicates songs in 
     playlist by song ID and displays songs in the order stored in the 
@@ -128,11 +133,11 @@ void playlist::save_summary(ofstream &writef){
         
         // Iterate through all songs in playlist in order.
         // For each song, write song ID to playlist followed by a space
-        for (list<song>::const_iterator ci=playlist_songs.begin(); ci != playlist_songs.end(); ci++){
-            song s = *ci;
-            
-            writef << s.get_id() << " " ;
-        }
+        playlist_songs.for_each_run([&](const uint32_t *ids, size_t n) {
+            for (size_t i=0; i<n; i++) {
+                writef << ids[i] << " " ;
+            }
+        });
     }
     
     // new line marks end of playlist
@@ -141,9 +146,27 @@ void playlist::save_summary(ofstream &writef){
 }
 
 
+/* Looks up each song in the playlist in songs and writes it a block at a
+    time. Songs removed from the songs file by a reload are left out.
+ */
+void playlist::write_songs(ostream &os, output_format f) const {
+    
+    song_writer writer(os, f);
+    playlist_songs.for_each_run([&](const uint32_t *ids, size_t n) {
+        for (size_t i=0; i<n; i++) {
+            if (ids[i] <= (uint32_t)songs->size()) {
+                writer.write(songs->get_song((int)ids[i]));
+            }
+        }
+    });
+    writer.flush();
+}
+
+
 /* Friend function of the playlist class that displays playlist to console in 
-    user-friendly formatted manner. Iterates through each node in the list
-    and writes to stream using overloaded << operator for song class. 
+    user-friendly formatted manner. Iterates through each song ID in the
+    playlist and writes the song to stream using a song_writer, formatted the same way as the
+    overloaded << operator for song class. 
  */
 ostream & operator << (ostream &os, const playlist &p) {
     
@@ -159,11 +182,9 @@ ostream & operator << (ostream &os, const playlist &p) {
         os << "Songs in playlist '" << p.name << "':" << endl;
         
         // Iterates through all songs in playlist in order
-        // For each song, write to stream using overloaded << for song class
-        for (list<song>::const_iterator ci=p.playlist_songs.begin() ; ci != p.playlist_songs.end(); ci++) {
-            song s = *ci;
-            os << s;
-        }
+        // For each song, write to stream a block at a time, formatted the
+        // same way as overloaded << for song class
+        p.write_songs(os, OUTPUT_TEXT);
         
         return os;
     }
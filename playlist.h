@@ -5,8 +5,12 @@
  Description: Playlist Class Definition (Header File)
 
  A single playlist of songs created and modified by the user.
- - Uses existing C++ std::list class functions to insert/delete songs into 
- playlist.
+ - Holds only the song ID of each song, in order, in an id_sequence, so songs
+ are inserted anywhere in time logarithmic in the length of the playlist,
+ and every copy of a song is found and deleted without reading the rest.
+ Songs are looked up in the song database when the playlist is displayed.
+ - Copies of a playlist share its song IDs until either is changed, so a
+ playlist is copied in constant time, whatever its length.
  - Writes a summary of playlist to a file stream.
 
 *****************************************************************************/
@@ -16,10 +20,14 @@
 
 #include <iostream>
 #include <string>
-#include <list>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 #include "song.h"
+#include "song_writer.h"
 #include "song_database.h"
+#include "id_sequence.h"
 
 using namespace std;
 
@@ -31,8 +39,11 @@ class playlist {
     // Playlist Name - All lowercase
     string name_lower;
     
-    // List of songs
-    list<song> playlist_songs;
+    // Song IDs of songs in playlist, in order
+    id_sequence playlist_songs;
+    
+    // Database songs are looked up in
+    const song_database *songs;
     
 public:
     
@@ -40,14 +51,29 @@ public:
      Playlist constructor
 ******************************************************************************/
     
-    /* playlist(string list_name)
+    /* playlist(string list_name, const song_database &s)
      Default constructor for playlist class. Initializes name with list_name and
-     playlist_songs as an empty doubly linked list. Converts any alphabet
+     playlist_songs as an empty sequence of song IDs. Converts any alphabet
      characters in name that are uppercase to lowercase characters and stores in
      name_lower.
         @param      string list_name [in] name of playlist
+        @param      song_database &s [in] database songs in the playlist are
+                                     looked up in. Must outlive the playlist.
+     */
+    playlist(string list_name, const song_database &s);
+    
+    /* playlist(const playlist &source, string list_name)
+     Constructor for a clone of playlist source named list_name, holding the
+     same songs, in the same order. Songs are shared with source, not copied,
+     until either playlist is changed, so a playlist of any length is cloned
+     in constant time.
+        @param      playlist &source [in] playlist to clone
+        @param      string list_name [in] name of clone
+        @post       Clone and source can be changed without changing the
+                    other. Changing either copies only the parts of the
+                    sequence of song IDs changed.
      */
-    playlist(string list_name);
+    playlist(const playlist &source, string list_name);
     
 /******************************************************************************
      Returning playlist variables / characteristics
@@ -95,14 +121,14 @@ public:
      Modify songs in playlist
 ******************************************************************************/
     
-    /* bool insert (song s, int pos)
+    /* bool insert (int sID, int pos)
      Inserts a song into the playlist at position pos.
-        @param      song s  [in] song to insert
+        @param      int sID [in] song ID of song to insert
         @param      int pos [in] position to insert song into
         @return     bool    [out] returns true if insertion was successful.
                             Else, returns false
         @pre        playlist_songs list is initialized and is of size n >= 0.
-        @post       s is inserted as a node in the playlist at position pos. If
+        @post       sID is inserted into the playlist at position pos. If
                     pos > n, s is inserted as last element of list. If pos < 1,
                     s is inserted at beginning of the list. If n == 0, s is 
                     is inserted as first and only element of list. All songs
@@ -111,9 +137,34 @@ public:
                     same order. Size of list increases by 1. Function returns
                     true if insertion is successful, else returns false.
      */
-    bool insert (song s, int pos);
+    bool insert (int sID, int pos);
     
     
+    /* bool insert_songs (const vector<uint32_t> &sIDs, int pos)
+     Inserts songs into the playlist at position pos, in order, as one
+     change.
+        @param      vector<uint32_t> &sIDs [in] song IDs of songs to insert
+        @param      int pos [in] position to insert first song into
+        @return     bool    [out] returns true if insertion was successful.
+                            Else, returns false
+        @pre        Every ID in sIDs is a song ID in the song database.
+        @post       sIDs are in the playlist from position pos on, in order.
+                    pos is clamped as insert clamps it. Songs after pos move
+                    sIDs.size() positions down the list, in the same order.
+     */
+    bool insert_songs (const vector<uint32_t> &sIDs, int pos);
+    
+    /* int delete_songs (const vector<uint32_t> &sIDs);
+     Deletes any songs from the playlist that have any song ID in sIDs, as
+     one change.
+        @param      vector<uint32_t> &sIDs [in] song IDs of songs to delete
+        @return     int         [out] returns -1 if list is empty, else
+                                number of songs deleted
+        @post       Playlist contains no songs with a song ID in sIDs. Other
+                    songs are unchanged and retain same order.
+     */
+    int delete_songs (const vector<uint32_t> &sIDs);
+    
     /* int delete_song (int sID);
      Deletes any songs from the playlist that have the song ID sID.
         @param      int sID     [in] song ID of song to delete
@@ -131,6 +182,16 @@ public:
                     of times a song was deleted from playlist.
      */
     int delete_song (int sID);
+    
+    /* int count_song (int sID) const;
+     Returns number of times song with song ID sID is in the playlist,
+     without reading the playlist.
+        @param      int sID     [in] song ID of song to count
+        @return     int         [out] number of times song is in playlist, 0
+                                if it isn't
+        @post       playlist_songs is unchanged.
+     */
+    int count_song (int sID) const;
 
     
 /******************************************************************************
@@ -151,6 +212,17 @@ public:
      */
     void save_summary (ofstream &writef);
     
+    /* void write_songs (ostream &os, output_format f) const;
+     Writes each song in the playlist, in order, to a stream as f, with no
+     playlist name or message around them. Songs are looked up by song ID in
+     the song database; songs no longer in it after a reload are left out.
+        @param      ostream &os      [in/out] stream to write out to
+        @param      output_format f  [in] how to write songs
+        @post       One line per song in playlist_songs is written to &os. If
+                    the playlist is empty, nothing is written.
+     */
+    void write_songs (ostream &os, output_format f) const;
+    
     /* friend ostream & operator << (ostream &os, const playlist &p);
      Overloading operator << to display playlist name and songs to console.
     Exists outside playlist class as a friend function.
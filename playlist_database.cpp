@@ -1,7 +1,7 @@
 #include "playlist_database.h"
 
 /* Default constructor for playlist_database class */
-playlist_database::playlist_database (ofstream &w, ostream &e) : writef(w), err(e) {}
+playlist_database::playlist_database (ofstream &w, const song_database &s, ostream &e) : writef(w), err(e), songs(s) {}
 
 /* Returns number of playlists in playlist_database */
 size_t playlist_database::size() { return database.size(); }
@@ -36,13 +36,47 @@ int playlist_database::is_existing_playlist(string &pName){
 /*Creates new playlist instance with passed parameter name. Pushes this to 
  database vector as the last element in the vector. */
 void playlist_database::add_new_playlist(string name){
-    playlist p(name);
+    playlist p(name, songs);
     database.push_back(p);
 }
 
+/* Creates a clone of database[pID] named name, and pushes it to database as
+    the last element in the vector.
+ */
+void playlist_database::clone_playlist(int pID, string name){
+    playlist p(database[pID], name);
+    database.push_back(p);
+}
+
+/* Versions are kept as they are: a copy of a playlist shares its songs */
+void playlist_database::remember(int pID, const playlist &before) {
+    change c = { pID, before };
+    undo_history.push_back(c);
+    if (undo_history.size() > HISTORY_MAX) {
+        undo_history.pop_front();
+    }
+    redo_history.clear();
+}
+
+/* Changes to pID are erased, and positions after pID moved up one */
+void playlist_database::forget_playlist(deque<change> &history, int pID) {
+    for (deque<change>::iterator it = history.begin(); it != history.end(); ) {
+        if (it->pID == pID) {
+            it = history.erase(it);
+        }
+        else {
+            if (it->pID > pID) {
+                it->pID--;
+            }
+            ++it;
+        }
+    }
+}
+
 /* Checks to see if pID is valid, i.e. is the position of an existing playlist
  in database. If pID is valid, erases the playlist from the database and returns
- true. Else does nothing and returns false.
+ true. Else does nothing and returns false. Changes to the playlist can no
+ longer be undone or redone.
  */
 bool playlist_database::delete_playlist(int pID) {
     if (pID < 0 || pID > size()-1) {
@@ -52,17 +86,22 @@ bool playlist_database::delete_playlist(int pID) {
     else {
         // pID is valid. Remove playlist from database.
         database.erase(database.begin()+pID);
+        forget_playlist(undo_history, pID);
+        forget_playlist(redo_history, pID);
     }
     
     return true;
 }
 
-/* Attempts so insert a song into playlist at database[pID]. If successful,
-    returns true. Else, returns false.
+/* Attempts so insert a song into playlist at database[pID], by its song ID.
+    If successful, remembers the playlist before the insertion, so it can be
+    undone, and returns true. Else, returns false.
  */
-bool playlist_database::insert_song_into_playlist(int pID, song s, int pos) {
+bool playlist_database::insert_song_into_playlist(int pID, const song &s, int pos) {
     
-    if (database[pID].insert(s,pos)) {
+    playlist before = database[pID];
+    if (database[pID].insert(s.get_id(),pos)) {
+        remember(pID, before);
         return true;
     }
     else { return false; }
@@ -73,9 +112,79 @@ bool playlist_database::insert_song_into_playlist(int pID, song s, int pos) {
     database[pID]. Returns number of times song was deleted. Will return 0 if
     no songs in the ID have song ID sID and so no deletions were made. If
     playlist is empty, returns -1 to indicate no deletions were attempted.
+    Playlist before any deletions is remembered, so they can be undone.
  */
 int playlist_database::delete_song_from_playlist(int pID, int sID) {
-    return database[pID].delete_song(sID);
+    
+    playlist before = database[pID];
+    int deletions = database[pID].delete_song(sID);
+    if (deletions > 0) {
+        remember(pID, before);
+    }
+    return deletions;
+}
+
+/* Inserts every song in sIDs into playlist at database[pID] at once, as one
+    change to undo.
+ */
+bool playlist_database::insert_songs_into_playlist(int pID, const vector<uint32_t> &sIDs, int pos) {
+    
+    playlist before = database[pID];
+    if (database[pID].insert_songs(sIDs, pos)) {
+        remember(pID, before);
+        return true;
+    }
+    return false;
+}
+
+/* Deletes every song in sIDs from playlist at database[pID] at once, as one
+    change to undo.
+ */
+int playlist_database::delete_songs_from_playlist(int pID, const vector<uint32_t> &sIDs) {
+    
+    playlist before = database[pID];
+    int deletions = database[pID].delete_songs(sIDs);
+    if (deletions > 0) {
+        remember(pID, before);
+    }
+    return deletions;
+}
+
+/* Swaps the playlist with the version the last change replaced, so the
+    change itself is kept, to be redone.
+ */
+bool playlist_database::undo(int &pID) {
+    
+    if (undo_history.empty()) {
+        return false;
+    }
+    
+    change &c = undo_history.back();
+    swap(database[c.pID], c.version);
+    pID = c.pID;
+    redo_history.push_back(move(c));
+    undo_history.pop_back();
+    return true;
+}
+
+/* Swaps the playlist with the version undoing the last change replaced */
+bool playlist_database::redo(int &pID) {
+    
+    if (redo_history.empty()) {
+        return false;
+    }
+    
+    change &c = redo_history.back();
+    swap(database[c.pID], c.version);
+    pID = c.pID;
+    undo_history.push_back(move(c));
+    redo_history.pop_back();
+    return true;
+}
+
+/* Returns number of times song sID is in playlist database[pID] */
+int playlist_database::count_song_in_playlist(int pID, int sID) {
+    return database[pID].count_song(sID);
 }
 
 /* Writes database[pID] to &os using overloaded operator << function for
@@ -85,6 +194,15 @@ void playlist_database::display_playlist(ostream &os, int pID){
     os << database[pID] << endl;
 }
 
+/* Text goes through operator <<, anything else straight to song_writer */
+void playlist_database::display_playlist(ostream &os, int pID, output_format f){
+    if (f == OUTPUT_TEXT) {
+        display_playlist(os, pID);
+        return;
+    }
+    database[pID].write_songs(os, f);
+}
+
 /* Returns name of playlist database[pID] */
 string playlist_database::get_playlist_name(int pID){
     return database[pID].get_name();
@@ -7,11 +7,14 @@
  - Stores all playlists created by user
  - Displays a list of all playlists the user has created
  - Adds/Deletes a playlist to the playlist database
+ - Clones a playlist, sharing its songs until either playlist is changed
  - Saves all playlists to file
  - Checks to see if a playlist of a given name already exists
  - Returns characteristics/variables of specified playlist in database
  - Add songs to specified playlist in database
  - Delete songs from specified playlist in database
+ - Keeps the versions of playlists that changes replaced, so changes can be
+ undone and redone
  
  *****************************************************************************/
 
@@ -21,6 +24,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <deque>
 
 #include "playlist.h"
 
@@ -37,24 +41,60 @@ class playlist_database {
     // Stream to write errors to
     ostream &err;
     
+    // Database songs in playlists are looked up in
+    const song_database &songs;
+    
+    // A change to the songs in playlist database[pID], with the version of
+    // the playlist it replaced, or, once undone, the version undoing it
+    // replaced. Versions share songs with the playlist, so cost next to
+    // nothing to keep.
+    struct change {
+        int pID;
+        playlist version;
+    };
+    
+    // Changes that can be undone, last made last, and changes undone that
+    // can be redone, last undone last
+    deque<change> undo_history;
+    deque<change> redo_history;
+    
+    /* void remember(int pID, const playlist &before);
+     Adds a change to database[pID] replacing before to undo_history, and
+     forgets changes that could be redone, as they no longer follow on.
+     */
+    void remember(int pID, const playlist &before);
+    
+    /* static void forget_playlist(deque<change> &history, int pID);
+     Drops changes to database[pID] from history, and moves changes to
+     playlists after it up one position, as database[pID] is deleted.
+     */
+    static void forget_playlist(deque<change> &history, int pID);
+    
 public:
 
+    // Most changes kept to undo
+    static const size_t HISTORY_MAX = 100;
+
 /******************************************************************************
     Playlist database constructor
  ******************************************************************************/
     
-    /* playlist_database(ofstream &w, ostream &e = cerr);
+    /* playlist_database(ofstream &w, const song_database &s,
+            ostream &e = cerr);
      Default constructor for playlist database class. Initializes &writef with 
-     ofstream &w to write to file and &err with ostream &e, which defaults to
-     cerr, to write errors. Initializes database as an empty vector of 
-     playlists.
+     ofstream &w to write to file, &songs with s to look songs up in, and &err
+     with ostream &e, which defaults to cerr, to write errors. Initializes
+     database as an empty vector of playlists.
         @param      ofstream &w     [out] stream to write to file
+        @param      song_database &s [in] database of songs playlists hold
+                                    song IDs of. Must outlive the playlist
+                                    database.
         @param      ostream &err    [in/out] stream to display errors to console
         @pre        &w and &err are open and initialized. 
         @post       database is an empty vector of playlists
      */
     
-    playlist_database(ofstream &w, ostream &e = cerr);
+    playlist_database(ofstream &w, const song_database &s, ostream &e = cerr);
     
 /******************************************************************************
     Returning playlist database variables / characteristics
@@ -100,6 +140,22 @@ public:
      */
     void add_new_playlist(string name);
     
+    /* void clone_playlist(int pID, string name);
+     Creates a new playlist with playlist.name = name holding the same songs
+     as playlist database[pID], in the same order. Adds to end of playlist
+     database. Songs are shared between the two until either is changed,
+     so cloning takes constant time, however many songs are in the playlist.
+        @param      int pID         [in] position in database of playlist to
+                                    clone
+        @param      string name     [in] name of clone
+        @pre        database is an initialized database of n playlists. pID is a
+                    non-empty, initialized integer >= 0 && < n. name is a
+                    nonempty string that is not the name of a playlist.
+        @post       Clone is added to database as database[n]. n increases by
+                    1. All other elements in database remain the same.
+     */
+    void clone_playlist(int pID, string name);
+    
     /* bool delete_playlist(int pID);
      Deletes playlist at database[pID] from playlist database.
         @param      int pID [in] position in database of playlist to delete
@@ -116,11 +172,11 @@ public:
     bool delete_playlist(int pID);
     
     
-    /* bool insert_song_into_playlist(int pID);
+    /* bool insert_song_into_playlist(int pID, const song &s, int pos);
      Inserts song s into the (pos)th position in playlist database[pID].
         @param      int pID [in] position in database of playlist to insert
                             song into
-        @param      song s  [in] song to insert
+        @param      song &s [in] song to insert
         @param      int pos [in] position in playlist to insert song into
         @return     bool    [out] returns true if insertion was successful,
                             else returns false.
@@ -129,7 +185,7 @@ public:
                     empty and initialized. pos is non-empty initialized integer.
                     There exists a function that inserts a given song into a 
                     given function in a playlist.
-        @post       s is inserted as a node in playist database[pID] at pos. If
+        @post       Song ID of s is inserted in playist database[pID] at pos. If
                     pos > n, s is inserted as last element of list. If pos < 1,
                     s is inserted at beginning of the list. If n == 0, s is
                     is inserted as first and only element of list. All songs
@@ -138,7 +194,7 @@ public:
                     same order. Size of list increases by 1. Function returns
                     true if insertion is successful, else returns false.
      */
-    bool insert_song_into_playlist(int pID, song s, int pos);
+    bool insert_song_into_playlist(int pID, const song &s, int pos);
     
     /* int delete_song_from_playlist(int pID, int sID);
      Deletes all instances of song with song ID sID from playlist at 
@@ -165,6 +221,72 @@ public:
      */
     int delete_song_from_playlist(int pID, int sID);
     
+    /* bool insert_songs_into_playlist(int pID, const vector<uint32_t> &sIDs,
+            int pos);
+     Inserts songs with song IDs sIDs, in order, into the (pos)th position
+     in playlist database[pID], as one change.
+        @param      int pID [in] position in database of playlist to insert
+                            songs into
+        @param      vector<uint32_t> &sIDs [in] song IDs of songs to insert
+        @param      int pos [in] position in playlist to insert first song into
+        @return     bool    [out] returns true if insertion was successful,
+                            else returns false.
+        @pre        database is an initialized database of n playlists. pID is a
+                    non-empty, initialized integer >= 0 && < n.
+        @post       sIDs are in database[pID] from pos on, pos clamped as
+                    insert_song_into_playlist clamps it.
+     */
+    bool insert_songs_into_playlist(int pID, const vector<uint32_t> &sIDs, int pos);
+    
+    /* int delete_songs_from_playlist(int pID, const vector<uint32_t> &sIDs);
+     Deletes all instances of songs with any song ID in sIDs from playlist at
+     database[pID], as one change.
+        @param      int pID [in] position in database of playlist to delete from
+        @param      vector<uint32_t> &sIDs [in] song IDs of songs to delete
+        @return     int     [out] returns -1 if list is empty, else number of
+                            songs deleted.
+        @pre        database is an initialized database of n playlists. pID is a
+                    non-empty, initialized integer >= 0 && < n.
+        @post       database[pID] contains no songs with a song ID in sIDs.
+     */
+    int delete_songs_from_playlist(int pID, const vector<uint32_t> &sIDs);
+    
+    /* int count_song_in_playlist(int pID, int sID);
+     Returns number of times song with song ID sID is in playlist
+     database[pID].
+        @param      int pID [in] position in database of playlist
+        @param      int sID [in] song ID of song to count
+        @return     int     [out] number of times song is in playlist
+        @pre        database is an initialized database of n playlists. pID is a
+                    non-empty, initialized integer >= 0 && < n.
+        @post       database[pID] is unchanged.
+     */
+    int count_song_in_playlist(int pID, int sID);
+    
+    /* bool undo(int &pID);
+     Undoes the last change made to the songs in any playlist, that has not
+     been undone, in constant time.
+        @param      int &pID [out] position in database of playlist changed
+        @return     bool    [out] returns true if a change was undone, else
+                            returns false if there are none to undo.
+        @pre        database is an initialized database of n playlists.
+        @post       database[pID] is as it was before the change. The change
+                    can be redone. Up to HISTORY_MAX changes can be undone.
+     */
+    bool undo(int &pID);
+    
+    /* bool redo(int &pID);
+     Makes the last change undone again, in constant time.
+        @param      int &pID [out] position in database of playlist changed
+        @return     bool    [out] returns true if a change was redone, else
+                            returns false if none was undone since the last
+                            change was made.
+        @pre        database is an initialized database of n playlists.
+        @post       database[pID] is as it was before the change was undone.
+                    The change can be undone again.
+     */
+    bool redo(int &pID);
+    
     /* void display_playlist(ostream &os, int pID);
      Displays songs and song data in playlist database[pID]
         @param      int pID         [in] position in database of playlist
@@ -179,6 +301,18 @@ public:
      */
     void display_playlist(ostream &os, int pID);
     
+    /* void display_playlist(ostream &os, int pID, output_format f);
+     Displays songs in playlist database[pID] as f. Text is displayed the
+     same way as above; tab separated values and JSON Lines are just the
+     songs, one per line, with no playlist name or message around them.
+        @param      ostream &os     [in/out] stream to display playlist to
+        @param      int pID         [in] position in database of playlist
+        @param      output_format f [in] how to write songs
+        @pre        As above.
+        @post       Songs in playlist database[pID] are written to &os as f.
+     */
+    void display_playlist(ostream &os, int pID, output_format f);
+    
     /* int get_playlist_size(int pID);
      Returns the number of songs in playlist database[pID].
         @param      int pID [in] position in database of playlist
@@ -0,0 +1,41 @@
+#include "prefix_index.h"
+
+#include <algorithm>
+
+/* Default constructor. Nothing to do until strings are indexed. */
+prefix_index::prefix_index(): column(NULL) {}
+
+/* Sorts ids by string, lowest id first among strings that are the same, then
+    keeps the first id of each run of the same string.
+ */
+void prefix_index::build(const folded_column &c, const vector<uint32_t> &ids) {
+
+    column = &c;
+    sorted = ids;
+
+    stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return c[a] < c[b]; });
+    sorted.erase(unique(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return c[a] == c[b]; }), sorted.end());
+    sorted.shrink_to_fit();
+}
+
+/* Strings starting with prefix_lower sort after every string less than it,
+    so the first is found with a binary search. The rest follow it, up to the
+    first string that no longer starts with prefix_lower.
+ */
+void prefix_index::complete(string_view prefix_lower, size_t n, vector<uint32_t> &ids) const {
+
+    ids.clear();
+
+    vector<uint32_t>::const_iterator it = lower_bound(sorted.begin(), sorted.end(), prefix_lower, [&](uint32_t id, string_view key) { return (*column)[id] < key; });
+
+    for (; it != sorted.end() && ids.size() < n; ++it) {
+        string_view s = (*column)[*it];
+        if (s.compare(0, prefix_lower.size(), prefix_lower) != 0) {
+            break;
+        }
+        ids.push_back(*it);
+    }
+}
+
+/* Returns number of ids in sorted */
+uint32_t prefix_index::size() const { return (uint32_t)sorted.size(); }
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ Title:       prefix_index.h
+ Description: Prefix Index Class Definition (Header File)
+
+ Sorted index of the distinct strings of a folded column, for completing
+ what a user has typed so far.
+ - Strings that are the same once case folded are kept once, by the id of
+ the first of them indexed.
+ - Strings starting with a prefix are next to each other in sorted order, so
+ they are found with a binary search and read off in order, without looking
+ at any other string.
+
+ *****************************************************************************/
+
+#ifndef ___prefix_index__
+#define ___prefix_index__
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "folded_column.h"
+
+using namespace std;
+
+class prefix_index {
+
+    // Column strings are kept in
+    const folded_column *column;
+
+    // Ids of distinct strings, sorted by string
+    vector<uint32_t> sorted;
+
+public:
+
+/******************************************************************************
+     Prefix index constructor
+******************************************************************************/
+
+    /* prefix_index();
+     Default constructor for prefix index class.
+        @post       Index is empty.
+     */
+    prefix_index();
+
+/******************************************************************************
+     Building the index
+******************************************************************************/
+
+    /* void build(const folded_column &c, const vector<uint32_t> &ids);
+     Indexes strings ids of c, replacing anything indexed before.
+        @param      const folded_column &c [in] column strings are kept in
+        @param      const vector<uint32_t> &ids [in] ids of strings to index,
+                                    in increasing order
+        @pre        Every id in ids is < c.size(). c is not changed or
+                    destroyed while the index is used.
+        @post       Of strings that are the same, only the one with the
+                    lowest id is indexed.
+     */
+    void build(const folded_column &c, const vector<uint32_t> &ids);
+
+/******************************************************************************
+     Searching the index
+******************************************************************************/
+
+    /* void complete(string_view prefix_lower, size_t n,
+            vector<uint32_t> &ids) const;
+     Finds the first n distinct strings, in sorted order, starting with
+     prefix_lower.
+        @param      string_view prefix_lower [in] prefix, already in lowercase
+        @param      size_t n        [in] most strings to find
+        @param      vector<uint32_t> &ids [out] ids of strings found, in
+                                    sorted order of their strings
+     */
+    void complete(string_view prefix_lower, size_t n, vector<uint32_t> &ids) const;
+
+    /* uint32_t size() const;
+     Returns number of distinct strings indexed.
+     */
+    uint32_t size() const;
+
+};
+
+#endif
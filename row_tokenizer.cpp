@@ -0,0 +1,131 @@
+#include "row_tokenizer.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Bytes scanned at once
+#if defined(__AVX2__)
+static const size_t BLOCK_BYTES = 32;
+#elif defined(__SSE2__)
+static const size_t BLOCK_BYTES = 16;
+#else
+static const size_t BLOCK_BYTES = 8;
+#endif
+
+/* Constructor. Scans first block of text. */
+row_tokenizer::row_tokenizer(const char *first, const char *l): last(l), next_row(first), block(first), mask(0) {
+    scan_block();
+}
+
+/* Scans the block starting at block. A whole block is compared against tab,
+    double quote and line break at once and the results are packed into one
+    bit per byte. Text at the end that is too short for a whole block is
+    scanned one byte at a time.
+ */
+void row_tokenizer::scan_block() {
+    
+    mask = 0;
+    
+    if (block >= last) {
+        return;
+    }
+    
+#if defined(__AVX2__)
+    if (last - block >= (ptrdiff_t)BLOCK_BYTES) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        mask = (uint32_t)_mm256_movemask_epi8(hits);
+        return;
+    }
+#elif defined(__SSE2__)
+    if (last - block >= (ptrdiff_t)BLOCK_BYTES) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        mask = (uint32_t)_mm_movemask_epi8(hits);
+        return;
+    }
+#endif
+    
+    size_t n = last - block < (ptrdiff_t)BLOCK_BYTES ? last - block : BLOCK_BYTES;
+    for (size_t i=0; i<n; i++) {
+        if (block[i] == '\t' || block[i] == '"' || block[i] == '\n') {
+            mask |= 1u << i;
+        }
+    }
+}
+
+/* Hands out the lowest bit left in mask, scanning blocks until one has a bit
+    set or the text runs out.
+ */
+const char *row_tokenizer::next_special() {
+    while (mask == 0) {
+        if (last - block <= (ptrdiff_t)BLOCK_BYTES) {
+            return last;
+        }
+        block += BLOCK_BYTES;
+        scan_block();
+    }
+    
+    const char *p = block + __builtin_ctz(mask);
+    mask &= mask - 1;
+    return p;
+}
+
+/* Walks through the special characters of the next row. A tab ends a field
+    and a line break ends the row. Double quotes are only counted: at the end
+    of each field, a quote at either end is trimmed off and any left over must
+    be inside the field.
+ */
+bool row_tokenizer::next(row_fields &r) {
+    
+    if (next_row >= last) {
+        return false;
+    }
+    
+    r.first = next_row;
+    r.count = 0;
+    
+    const char *field = next_row;
+    int quotes = 0;
+    
+    for (;;) {
+        const char *p = next_special();
+        
+        // End of field, and of row if at a line break or end of text
+        if (p == last || *p != '"') {
+            
+            bool end_of_row = (p == last || *p == '\n');
+            
+            // getline does not make an empty field out of nothing after the
+            // last tab in a row, or out of an empty row
+            if (!(end_of_row && p == field)) {
+                if (r.count < MAX_ROW_FIELDS) {
+                    string_view raw(field, p - field);
+                    string_view text = raw;
+                    if (!text.empty() && text.front() == '"') { text.remove_prefix(1); quotes--; }
+                    if (!text.empty() && text.back() == '"') { text.remove_suffix(1); quotes--; }
+                    
+                    r.raw[r.count] = raw;
+                    r.text[r.count] = text;
+                    r.inner_quotes[r.count] = (quotes > 0);
+                }
+                r.count++;
+            }
+            
+            if (end_of_row) {
+                r.last = p;
+                next_row = (p == last) ? last : p + 1;
+                return true;
+            }
+            
+            field = p + 1;
+            quotes = 0;
+        }
+        else {
+            quotes++;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ Title:       row_tokenizer.h
+ Description: Row Tokenizer Class Definition (Header File)
+
+ Splits tab delimited text into rows and fields in a single pass.
+ - Finds tabs, double quotes and line breaks 16 bytes at a time with SSE2 (32
+ bytes at a time with AVX2 when built with -mavx2), one byte at a time on
+ other processors.
+ - Hands back each row as views of its fields with enclosing double quotes 
+ already removed. Nothing is copied.
+
+ *****************************************************************************/
+
+#ifndef ___row_tokenizer__
+#define ___row_tokenizer__
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Most fields of a row that are kept. Any more are only counted.
+const size_t MAX_ROW_FIELDS = 8;
+
+// A single row of tab delimited text
+struct row_fields {
+    
+    // Row, not including its line break
+    const char *first;
+    const char *last;
+    
+    // Number of fields in row. Can be more than MAX_ROW_FIELDS.
+    size_t count;
+    
+    // Fields exactly as they are in the text
+    string_view raw[MAX_ROW_FIELDS];
+    
+    // Fields with a double quote at either end removed
+    string_view text[MAX_ROW_FIELDS];
+    
+    // True if text still has double quotes inside it
+    bool inner_quotes[MAX_ROW_FIELDS];
+};
+
+class row_tokenizer {
+    
+    // End of text
+    const char *last;
+    
+    // Start of the next row
+    const char *next_row;
+    
+    // Block of text being scanned, and a bit for each tab, double quote and
+    // line break in it that hasn't been handed out yet
+    const char *block;
+    uint32_t mask;
+    
+    /* const char *next_special();
+     Returns the next tab, double quote or line break, or last if there are no
+     more. Scans a whole block of text whenever the current one runs out.
+     */
+    const char *next_special();
+    
+    /* void scan_block();
+     Fills mask with the special characters in the block starting at block.
+     */
+    void scan_block();
+    
+public:
+    
+/******************************************************************************
+     Row tokenizer constructor
+******************************************************************************/
+    
+    /* row_tokenizer(const char *first, const char *last);
+     Constructor for row tokenizer class.
+        @param      const char *first   [in] first character of text
+        @param      const char *last    [in] one past last character of text
+        @pre        [first, last) stays valid while the tokenizer and the rows
+                    it hands back are used.
+        @post       Tokenizer is positioned at the first row of the text.
+     */
+    row_tokenizer(const char *first, const char *last);
+    
+/******************************************************************************
+     Reading rows
+******************************************************************************/
+    
+    /* bool next(row_fields &r);
+     Reads the next row of the text.
+        @param      row_fields &r   [out] row that was read
+        @return     bool            [out] returns true if a row was read, else
+                                    returns false at the end of the text.
+        @post       Rows end at a line break or at the end of the text. A line
+                    break at the very end of the text does not start another
+                    row. Fields are split the same way reading them with 
+                    getline would, so a single tab at the end of a row does not
+                    start another field and an empty row has no fields.
+     */
+    bool next(row_fields &r);
+    
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "search_cache.h"
+
+/* Constructor. Nothing is cached and nothing has been looked up yet. */
+search_cache::search_cache(size_t bytes): max_bytes(bytes), used_bytes(0), hits(0), misses(0) {}
+
+/* Field as one leading character, then key */
+string search_cache::make_key(query_field field, string_view key_lower) {
+    string key(1, (char)field);
+    key.append(key_lower.data(), key_lower.size());
+    return key;
+}
+
+/* Key and song IDs, plus the list node and hash table entry that hold them */
+size_t search_cache::entry_bytes(const entry &e) {
+    return sizeof(entry) + 4 * sizeof(void *) + 2 * e.key.size() + e.ids.size() * sizeof(uint32_t);
+}
+
+/* Moves a result found to the front of entries */
+const vector<uint32_t> * search_cache::find(query_field field, string_view key_lower) {
+
+    unordered_map<string, list<entry>::iterator>::iterator found = positions.find(make_key(field, key_lower));
+    if (found == positions.end()) {
+        misses++;
+        return NULL;
+    }
+
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return &found->second->ids;
+}
+
+/* Replaces any result already cached for the same search, then drops
+    results from the back of entries until the new one fits.
+ */
+void search_cache::insert(query_field field, string_view key_lower, const vector<uint32_t> &ids) {
+
+    entry e;
+    e.key = make_key(field, key_lower);
+    e.ids = ids;
+
+    size_t bytes = entry_bytes(e);
+    if (bytes > max_bytes) {
+        return;
+    }
+
+    unordered_map<string, list<entry>::iterator>::iterator found = positions.find(e.key);
+    if (found != positions.end()) {
+        used_bytes -= entry_bytes(*found->second);
+        entries.erase(found->second);
+        positions.erase(found);
+    }
+
+    while (used_bytes + bytes > max_bytes) {
+        used_bytes -= entry_bytes(entries.back());
+        positions.erase(entries.back().key);
+        entries.pop_back();
+    }
+
+    entries.push_front(e);
+    positions[entries.front().key] = entries.begin();
+    used_bytes += bytes;
+}
+
+/* Empties entries and positions */
+void search_cache::clear() {
+    entries.clear();
+    positions.clear();
+    used_bytes = 0;
+}
+
+/* Hit rate is hits out of every lookup */
+void search_cache::display_stats(ostream &os) const {
+
+    long long lookups = hits + misses;
+    os << "Search cache: " << hits << " hits, " << misses << " misses (" << (lookups > 0 ? hits * 100 / lookups : 0) << "% hit rate). " << entries.size() << " results cached in " << used_bytes << " of " << max_bytes << " bytes." << endl;
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ Title:       search_cache.h
+ Description: Search Cache Class Definition (Header File)
+
+ Cache of search results, so a search that is repeated doesn't have to look
+ through every song again.
+ - Results are the song IDs a search found, kept by the field searched and
+ the case folded key searched for.
+ - Holds results up to a set number of bytes. When another result wouldn't
+ fit, the results used least recently are dropped first.
+ - Counts how many searches were found in the cache, and how many weren't.
+
+ *****************************************************************************/
+
+#ifndef ___search_cache__
+#define ___search_cache__
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "song_query.h"
+
+using namespace std;
+
+class search_cache {
+
+    // A cached result, and the field and key it was found for, packed into
+    // one string
+    struct entry {
+        string key;
+        vector<uint32_t> ids;
+    };
+
+    // Results, most recently used first
+    list<entry> entries;
+
+    // Where each result is in entries, by key
+    unordered_map<string, list<entry>::iterator> positions;
+
+    // Bytes results are allowed to use, and bytes they use
+    size_t max_bytes;
+    size_t used_bytes;
+
+    // Searches found in the cache and not found in it
+    long long hits;
+    long long misses;
+
+    /* static string make_key(query_field field, string_view key_lower);
+     Returns field and key_lower packed into one string.
+     */
+    static string make_key(query_field field, string_view key_lower);
+
+    /* static size_t entry_bytes(const entry &e);
+     Returns about how many bytes e uses, its place in the cache included.
+     */
+    static size_t entry_bytes(const entry &e);
+
+public:
+
+/******************************************************************************
+     Search cache constructor
+******************************************************************************/
+
+    /* search_cache(size_t bytes);
+     Constructor for search cache class.
+        @param      size_t bytes    [in] most bytes results may use
+        @post       Cache is empty.
+     */
+    search_cache(size_t bytes);
+
+/******************************************************************************
+     Using the cache
+******************************************************************************/
+
+    /* const vector<uint32_t> * find(query_field field, string_view key_lower);
+     Looks up result of searching field for key_lower.
+        @return     const vector<uint32_t> * [out] song IDs found by the
+                                    search, or NULL if it isn't cached
+        @post       A result found is now the most recently used. Counts a
+                    hit if a result was found, else a miss.
+     */
+    const vector<uint32_t> * find(query_field field, string_view key_lower);
+
+    /* void insert(query_field field, string_view key_lower,
+            const vector<uint32_t> &ids);
+     Caches ids as result of searching field for key_lower, as the most
+     recently used result.
+        @post       Results used least recently are dropped until ids fits.
+                    A result too big for the whole cache isn't cached.
+     */
+    void insert(query_field field, string_view key_lower, const vector<uint32_t> &ids);
+
+    /* void clear();
+     Drops every result. Hit and miss counts are kept.
+     */
+    void clear();
+
+/******************************************************************************
+     Displaying cache statistics
+******************************************************************************/
+
+    /* void display_stats(ostream &os) const;
+     Writes number of hits, misses, hit rate, results cached and bytes used
+     to &os.
+     */
+    void display_stats(ostream &os) const;
+
+};
+
+#endif
@@ -4,6 +4,10 @@
  Created on:  Oct 12, 2014
  Description: Song class definition (Header File)
                 A single song object containing song data
+                
+ A song is a view of a song in a song_database. It holds no text of its own,
+ so copying one copies a few words, never song text. Pass songs by const
+ reference where a copy isn't needed.
  
 *****************************************************************************/
 
@@ -12,22 +16,28 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <iomanip>
 
 using namespace std;
 
 class song {
+    
+    // Text fields do not own their characters. They point into storage owned
+    // by the song_database the song was loaded into (the mapped songs file or
+    // the database's own copy of the text) and are only valid while that
+    // database exists.
     int id;
-    string title;
-    string artist;
-    string album;
-    string genre;
+    string_view title;
+    string_view artist;
+    string_view album;
+    string_view genre;
     int size;
     int time;
     int time_mins;
     int time_secs;
     int year;
-    string comments;
+    string_view comments;
     
 /******************************************************************************
     Friend classes and functions
@@ -40,6 +50,12 @@ class song {
     
     friend class song_database;
     
+    /* friend class song_writer;
+    Allows song_writer class to read song fields, to format them.
+     */
+    
+    friend class song_writer;
+    
     /* friend ostream & operator << (ostream &os, const song &s);
      Overloading operator << to display song id, title, artist, album, 
      time and year to console in a formatted user-friendly style.
@@ -66,13 +82,14 @@ class song {
 
 public:
     
-    /* string get_title()
-     Returns title of song.
-        @return     string      [out] title of song
+    /* string_view get_title()
+     Returns title of song, without copying it.
+        @return     string_view [out] title of song
         @pre        title is a initialized and non-empty string.
-        @post       title is returned and unchanged.
+        @post       title is returned and unchanged. It is only valid while the
+                    song_database the song came from exists.
      */
-    string get_title() const;
+    string_view get_title() const;
     
     /* string get_title()
      Returns song ID of song.
@@ -1,16 +1,144 @@
 
 #include "song_database.h"
 
+#include <cstring>
+#include <climits>
+#include <cctype>
+#include <thread>
+#include <cstdio>
+#include <sys/stat.h>
+
+// Relative cost of checking one song against a query term: comparing a
+// number, looking up whether a name matched, searching a case folded title,
+// and folding a field before searching it
+static const double QUERY_NUMBER_COST = 1;
+static const double QUERY_NAME_COST = 2;
+static const double QUERY_FOLDED_TEXT_COST = 8;
+static const double QUERY_TEXT_COST = 20;
+
+// Relative cost of listing one song from an index, sorting songs listed
+// out of song ID order included
+static const double QUERY_INDEX_ROW_COST = 4;
+
+// Fraction of songs a query term is guessed to let through when it can't be
+// counted: a text key, a single number, and a range of numbers
+static const double QUERY_TEXT_SELECTIVITY = 0.1;
+static const double QUERY_EQUAL_SELECTIVITY = 0.1;
+static const double QUERY_RANGE_SELECTIVITY = 1.0 / 3;
+
+/* Converts a field of the songs file to an integer the same way reading it 
+    into an int with a stringstream would: skips leading whitespace, reads an
+    optional sign and as many digits as follow. A field with no leading digits
+    is 0 and a value too large for an int is clamped to the int range.
+ */
+static int to_int(string_view field) {
+    
+    size_t i = 0;
+    while (i < field.size() && isspace((unsigned char)field[i])) { i++; }
+    
+    bool negative = false;
+    if (i < field.size() && (field[i] == '-' || field[i] == '+')) {
+        negative = (field[i] == '-');
+        i++;
+    }
+    
+    long long value = 0;
+    for (; i < field.size() && isdigit((unsigned char)field[i]); i++) {
+        value = value*10 + (field[i] - '0');
+        
+        // Clamp, and stop accumulating before value itself can overflow
+        if (value > (long long)INT_MAX + 1) {
+            value = (long long)INT_MAX + 1;
+        }
+    }
+    
+    if (negative) {
+        return value > (long long)INT_MAX ? INT_MIN : -(int)value;
+    }
+    return value > INT_MAX ? INT_MAX : (int)value;
+}
+
+/* Hashes n bytes starting at p, 8 bytes at a time. Fast enough to run over
+    the whole songs file every time it is loaded, and only used to tell whether
+    a file has changed.
+ */
+static uint64_t hash_bytes(const char *p, size_t n) {
+    
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+    
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    
+    // Last few bytes that don't make up a full 8
+    for (; i < n; i++) {
+        h = (h ^ (unsigned char)p[i]) * 0x100000001b3ULL;
+    }
+    
+    h ^= h >> 29;
+    return h;
+}
+
+/* Layout of a snapshot file. The header is followed by one int32 column for
+    each of size, time (in seconds) and year, padded to a multiple of 8 bytes,
+    then a uint64 column holding the hash of the line each song was parsed
+    from, then one uint32 column for each of artist, album and genre ids,
+    padded, then the text lists. There are five text lists: titles and
+    comments, with one string per row, and the artist, album and genre
+    dictionaries, with one string per name. A list of k strings has k+1 uint32
+    offsets, and string i of it is at offsets[i] up to offsets[i+1] in the
+    blob that follows the offsets of every list. Padding after the offsets
+    keeps the file a whole number of 8 byte words. Songs files with more than
+    4GB of text are not snapshotted. Every row in the database, including the
+    field headers at row 0, is a row of the snapshot.
+ */
+struct snapshot_header {
+    char magic[8];
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint64_t rows;
+    uint64_t names[3];
+    uint64_t blob_size;
+};
+
+static const char SNAPSHOT_MAGIC[8] = {'J','B','S','N','A','P','0','3'};
+
+// Number of text lists in a snapshot: titles, comments, artists, albums and
+// genres, stored in this order
+static const int SNAPSHOT_TEXT_LISTS = 5;
+
+/* Number of strings in each text list of a snapshot */
+static void snapshot_list_sizes(const snapshot_header &h, uint64_t sizes[SNAPSHOT_TEXT_LISTS]) {
+    sizes[0] = h.rows;
+    sizes[1] = h.rows;
+    sizes[2] = h.names[0];
+    sizes[3] = h.names[1];
+    sizes[4] = h.names[2];
+}
+
+/* Size in bytes of three 4 byte columns of a snapshot, padding included */
+static size_t snapshot_column_bytes(uint64_t rows) {
+    return (rows * 3 * sizeof(int32_t) + 7) / 8 * 8;
+}
+
+/* Size in bytes of the text offsets of a snapshot, padding included */
+static size_t snapshot_offsets_bytes(const snapshot_header &h) {
+    return ((2 * h.rows + h.names[0] + h.names[1] + h.names[2] + SNAPSHOT_TEXT_LISTS) * sizeof(uint32_t) + 7) / 8 * 8;
+}
+
 /* Default constructor for song_database.
     Populates song database vector with song data from file provided by user.
-    Performs several checks for file validity: checks to see if headers are
-    valid, whether all lines in file contain 8 tab delimited fields, whether
-    file can be opened successfuly and whether each song contains a non-empty
-    artist and title field. Ensures all inputs are read in as the appropriate 
-    datatypes and escapes all enclosing double quotes ("). If file is invalid,
-    writes errors to error stream and exits with error code -1. 
+    Reads file line by line and keeps a copy of each line in text_store for the
+    song's text fields to point into. Each line is checked and added to the 
+    database by add_song. If file can't be opened, writes errors to error
+    stream and exits with error code -1.
  */
-song_database::song_database(ifstream &readf, string fName, ostream &o, ostream &err): os(o) {
+song_database::song_database(ifstream &readf, string fName, ostream &o, ostream &err): os(o), loaded(0), load_failure(LOAD_OK), source_name(fName), keep_snapshot(false), search_index(false), search_index_built(false), folded_built(false), numeric_index_built(false), name_songs_built(false), fuzzy_built(false), prefix_built(false), search_threads(1), output(OUTPUT_TEXT), search_results(SEARCH_CACHE_BYTES) {
     
     // Open file
     readf.open(fName.c_str());
@@ -30,222 +158,2002 @@ song_database::song_database(ifstream &readf, string fName, ostream &o, ostream
         int n=0;
         
         // Read line, while we are able to read lines
+        // Keep line so song fields can point into it
         while (getline(readf,line)){
-            
-            // Create new stringstream with current line
-            istringstream ss(line);
-            vector<string> song_fields;
-            string field;
-            
-            // While we are able to read fields in the current line
-            //      Read line until we reach a tab character
-            //      Push back what we've read into song_fields vector
-            //      Start again and read the next field in current line
-            while (getline(ss,field,'\t')) {
-                song_fields.push_back(field);
-            }
-            
-            // Checks the number of fields in line
-            // If a line doesn't contain 8 fields, file is invalid so must
-            // Exit with errors
-            if (song_fields.size() != 8) {
-                err << "INVALID FILE: One or more of the lines in your songs file either has missing fields, \ncontains fields not separated by single tabs or \nhas more than 8 fields.\nPlease check your file and try again. \n" << endl;
-                
-                exit(-1);
-            }
-            
-            // Checks if one or more of the song fields in current line is empty
-            // If so, file is invalid. Exit with errors.
-            for (int i=0; i<song_fields.size(); i++){
-                if (song_fields[i].empty()) {
-                    err << "INVALID FILE: One or more of the lines in your songs file has missing fields or\ncontains fields not separated by single tabs.\nPlease check your file and try again. \n" << endl;
-                    exit(-1);
-                }
-                
-                // Remove double quotes from all fields
-                for (int j=0; j<song_fields[i].length(); j++) {
-                    if (song_fields[i][j] == '\"'){
-                        song_fields[i].erase(song_fields[i].begin()+j);
-                        j--;
-                    }
-                }                
-            }
-
-            // We are at the first line in the file. Must verify headings are
-            // correct. If any are incorrect, exit with errors.
-            if (n == 0) {
-                if (song_fields[0] != "Name" || song_fields[1] != "Artist" || song_fields[2] != "Album" || song_fields[3] != "Genre" || song_fields[4] != "Size" || song_fields[5] != "Time" || song_fields[6] != "Year" || song_fields[7] != "Comments") {
-                    
-                    err << "INVALID FILE: Incorrect header(s).\nPlease check your file and try again. \n" << endl;
-                    exit(-1);
-                }
-                
-            }
-            // We have passed the first line in the file.
-            // Rest of lines in file now contain song data.
-            // Create new instance of a song
-            song s;
-            
-            // Check to see if Name or Artist field is empty
-            // If so, exit with errors
-            if (song_fields[0].empty() || song_fields[1].empty()) {
-                err << "INVALID FILE: One or more of the songs in your songs file is missing a Name and/or an Artist field. \nPlease check your file and try again. \n" << endl;
-                exit(-1);
-            }
-            
-            // Populate new song instance from fields read into song_fields vec
-            // Song id is determined by what line in the file we're on
-            s.id = n;
-            s.title = song_fields[0];
-            s.artist = song_fields[1];
-            s.album = song_fields[2];
-            s.genre = song_fields[3];
-            
-            // Must pass s.size, s.time and s.year as integers, not strings
-            // If field is not empty, read as integer datatype using
-            // stringstream.
-            if (!song_fields[4].empty()){
-                istringstream ssSize(song_fields[4]);
-                ssSize >> s.size;
-            }
-            else {
-                s.size = '\0';
-            }
-            
-            if (!song_fields[5].empty()){
-                int time;
-                istringstream ssTime(song_fields[5]);
-                ssTime >> time;
-                
-                // Convert time in seconds to mins and secs
-                s.time_mins = time/60;
-                s.time_secs = time%60;
-            }
-            else {
-                s.time_mins = '\0';
-                s.time_secs = '\0';
-            }
-            
-            if (!song_fields[6].empty()){
-                istringstream ssYear(song_fields[6]);
-                ssYear >> s.year;
-            }
-            else {
-                s.year = '\0';
-            }
-            
-            s.comments = song_fields[7];
-            
-            // Add s as last song in database
-            database.push_back(s);
+            text_store.push_back(line);
+            const string &kept = text_store.back();
+            add_song(kept.data(), kept.data() + kept.size(), n, err);
             
             // Advance to next line
             n++;
-            
         }
     }
     
     // Close file
     readf.close();
+    stamp = stamp_file(fName, NULL);
     
-    // Number of songs is number of elements in datbase minus
-    // field headers line at database[0]
-    num_of_songs = database.size()-1;
+    // Number of songs is number of rows in datbase minus
+    // field headers line at row 0
+    num_of_songs = (int)rows()-1;
+    loaded = (int)rows();
     
     // Tell user database was successfully loaded
     // If load was unsuccessful, program would have exited with errors
     os << "SUCCESS! " << num_of_songs << " songs were loaded. \n" << endl;
 }
 
-/* Convert a string to lowercase*/
-string song_database::lowercase(string word) const{
-    transform(word.begin(), word.end(), word.begin(), ::tolower);
-    return word;
+/* Memory mapped constructor for song_database.
+    Maps the songs file into memory. If asked to, tries to load the database
+    from a snapshot of the songs file first. Else, parses the file in place
+    with load_lines, so song text fields point straight into the mapping, and
+    writes a snapshot for next time if asked to. If file can't be opened or
+    mapped, writes errors to error stream and exits with error code -1.
+ */
+song_database::song_database(const string &fName, int threads, bool use_snapshot, bool progressive, ostream &o, ostream &err): os(o), loaded(0), load_failure(LOAD_OK), source_name(fName), keep_snapshot(use_snapshot), search_index(false), search_index_built(false), folded_built(false), numeric_index_built(false), name_songs_built(false), fuzzy_built(false), prefix_built(false), search_threads(1), output(OUTPUT_TEXT), search_results(SEARCH_CACHE_BYTES) {
+    
+    // If file could not be opened, exit with errors
+    if (!source.open(fName)) {
+        err << "ERROR: Could not open " << fName << " file. \nPlease check your file name and location and try again from the command line." << endl;
+        exit(-1);
+    }
+    
+    // One thread per core unless told otherwise
+    if (threads < 1) {
+        threads = thread::hardware_concurrency();
+    }
+    
+    // Small files are parsed faster than threads can be started
+    if (threads < 1 || source.size() < MIN_PARALLEL_BYTES) {
+        threads = 1;
+    }
+    
+    // Contents only need hashing to match up with a snapshot
+    string snapName = fName + ".snapshot";
+    stamp = stamp_file(fName, use_snapshot ? &source : NULL);
+    
+    // Songs file is no longer needed once loaded from the snapshot
+    if (use_snapshot && load_snapshot(snapName, stamp)) {
+        source.close();
+        loaded = (int)rows();
+    }
+    
+    // Songs are parsed in the background. Snapshot is written once they are
+    // all loaded.
+    else if (progressive && source.size() >= MIN_PROGRESSIVE_BYTES) {
+        load_progressive(source.begin(), source.end(), use_snapshot ? snapName : string(), stamp, err);
+    }
+    
+    else {
+        load_lines(source.begin(), source.end(), threads, err);
+        loaded = (int)rows();
+        
+        if (use_snapshot) {
+            save_snapshot(snapName, stamp);
+        }
+    }
+    
+    // Number of songs is number of rows in datbase minus
+    // field headers line at row 0
+    num_of_songs = (int)rows()-1;
+    
+    // Tell user database is being loaded
+    if (is_loading()) {
+        os << "LOADING! " << num_of_songs << " songs are being loaded. You can start browsing right away. \n" << endl;
+        return;
+    }
+    
+    // Tell user database was successfully loaded
+    // If load was unsuccessful, program would have exited with errors
+    os << "SUCCESS! " << num_of_songs << " songs were loaded. \n" << endl;
 }
 
-/* Returns a song from database at database[songid]
-    1 <= songid <= num_of_songs as the first element in the song database is
-    made up of the song headers
+/* Destructor for song_database. A progressive load still running in the
+    background points into this database, so must finish first.
  */
-song song_database::get_song(int songid) const { return database[songid]; }
-
-
-/* Returns how many songs are in the database */
-const int song_database::size() const { return num_of_songs; }
+song_database::~song_database() {
+    if (loader.joinable()) {
+        loader.join();
+    }
+}
 
+/* Counts the lines in [first, last). Each line ends at a line break or at the
+    end of the text. A line break at the very end does not start another line.
+ */
+static int count_lines(const char *first, const char *last) {
+    int n = 0;
+    while (first < last) {
+        const char *eol = static_cast<const char *>(memchr(first, '\n', last - first));
+        if (eol == NULL) {
+            eol = last;
+        }
+        first = eol + 1;
+        n++;
+    }
+    return n;
+}
 
-/* Displays songs from datbase[first] to databse[last]. Performs checks on first
-    and last to ensure this can be done with no out of range errors. Iterates
-    through songs in database using a for loop and displays each song using
-    overloaded << operator.
+/* Splits [first, last) into one chunk per thread. Each chunk starts roughly
+    an equal share of bytes into the text, moved forward to the start of the
+    next line. Lines in each chunk are counted first so each thread knows the
+    line number its chunk starts at, then database is sized to hold every line
+    and each thread parses its chunk straight into its own range of rows.
+    A thread stops at the first invalid line in its chunk. Since the first
+    invalid line in the file is in the first chunk that has one, that is the
+    error reported, as it would be if the file was parsed one line at a time.
+    Names each thread interned are then merged chunk by chunk, in file order.
  */
-const void song_database::list_songs(int first, int last) const{
+void song_database::load_lines(const char *first, const char *last, int threads, ostream &err) {
     
-    // If last > num_of_songs, only displays until database[num_of_songs]
-    if (last > num_of_songs ) { last = num_of_songs; }
+    // Start of each chunk, and end of the last one
+    vector<const char *> bounds(threads + 1);
+    bounds[0] = first;
+    bounds[threads] = last;
+    for (int t=1; t<threads; t++) {
+        const char *p = first + (last - first) / threads * t;
+        if (p < bounds[t-1]) {
+            p = bounds[t-1];
+        }
+        const char *eol = static_cast<const char *>(memchr(p, '\n', last - p));
+        bounds[t] = (eol == NULL) ? last : eol + 1;
+    }
     
-    // If first < 1, only displays starting at datbase[1]
-    if (first < 1) { first = 1; }
+    // Line number each chunk starts at
+    vector<int> first_line(threads + 1, 0);
+    vector<thread> workers;
+    for (int t=0; t<threads; t++) {
+        workers.push_back(thread([&, t] {
+            first_line[t+1] = count_lines(bounds[t], bounds[t+1]);
+        }));
+    }
+    for (int t=0; t<threads; t++) {
+        workers[t].join();
+    }
+    workers.clear();
+    
+    for (int t=0; t<threads; t++) {
+        first_line[t+1] += first_line[t];
+    }
+    
+    resize_rows(first_line[threads]);
+    
+    // First error found in each chunk, the copied text of its fields and the
+    // names in it
+    vector<load_error> errors(threads, LOAD_OK);
+    vector< list<string> > stores(threads);
+    vector<name_dictionaries> chunk_names(threads);
+    
+    for (int t=0; t<threads; t++) {
+        workers.push_back(thread([&, t] {
+            row_tokenizer tokens(bounds[t], bounds[t+1]);
+            row_fields r;
+            song s;
+            int n = first_line[t];
+            while (tokens.next(r)) {
+                errors[t] = parse_song(r, n, s, stores[t]);
+                if (errors[t] != LOAD_OK) {
+                    return;
+                }
+                set_row(n, s, chunk_names[t]);
+                line_hash[n] = hash_bytes(r.first, r.last - r.first);
+                
+                // Advance to next line
+                n++;
+            }
+        }));
+    }
+    for (int t=0; t<threads; t++) {
+        workers[t].join();
+    }
     
-    // Displays songs from first to last
-    for (int i=first; i<last+1; i++) {
-        os << database[i];
+    // Report first invalid line in file, if any
+    for (int t=0; t<threads; t++) {
+        if (errors[t] != LOAD_OK) {
+            report_load_error(errors[t], err);
+        }
+        text_store.splice(text_store.end(), stores[t]);
     }
     
+    // Give names their ids in the whole file
+    for (int t=0; t<threads; t++) {
+        merge_names(names.artists, chunk_names[t].artists, artist_ids, first_line[t], first_line[t+1]);
+        merge_names(names.albums, chunk_names[t].albums, album_ids, first_line[t], first_line[t+1]);
+        merge_names(names.genres, chunk_names[t].genres, genre_ids, first_line[t], first_line[t+1]);
+    }
 }
 
-/* Displays songs containing key string as a substring of the artist field.
-    Compares lowercase versions of both key and artist field to make search case
-    insensitive. Returns number of times key was found as substring
+/* Interns names of from into into in the order from gave them ids, noting the
+    id each gets in into, then looks up the new id of every id in the rows.
  */
-const int song_database::display_songs_by_artist(string &key) const{
+void song_database::merge_names(string_dictionary &into, const string_dictionary &from, vector<uint32_t> &ids, int first, int last) {
     
-    // Number of times key is found as substring
-    int count = 0;
+    vector<uint32_t> new_ids(from.size());
+    for (uint32_t i=0; i<from.size(); i++) {
+        new_ids[i] = into.intern(from[i]);
+    }
     
-    // Lowercase version of key
-    string key_lower = lowercase(key);
+    for (int n=first; n<last; n++) {
+        ids[n] = new_ids[ids[n]];
+    }
+}
+
+/* Counts lines so database can be sized up front and never has to grow while
+    songs are being read from it. Dictionaries are sized for every line to
+    have names of its own, so they never move names that are being read
+    either. Parses the field headers straight away, then
+    hands the rest of the file to a background thread. The thread parses lines
+    in order and, after every LOAD_BATCH lines, publishes them by storing the
+    new count in loaded and waking anything waiting in wait_for. Songs below
+    loaded are never written again, so they can be read without locking. An
+    invalid line stops the thread, publishing the lines before it and the
+    error in load_failure for load_failed to report, as exiting would lose
+    playlists the user has not saved.
+ */
+void song_database::load_progressive(const char *first, const char *last, const string &snapName, const source_stamp &stamp, ostream &err) {
+    
+    resize_rows(count_lines(first, last));
+    names.artists.reserve(rows());
+    names.albums.reserve(rows());
+    names.genres.reserve(rows());
+    
+    // Reject a file that isn't a songs file before the menu is displayed
+    row_tokenizer tokens(first, last);
+    row_fields r;
+    int n = 0;
+    if (tokens.next(r)) {
+        song s;
+        load_error e = parse_song(r, 0, s, text_store);
+        if (e != LOAD_OK) {
+            report_load_error(e, err);
+        }
+        set_row(0, s, names);
+        line_hash[0] = hash_bytes(r.first, r.last - r.first);
+        n = 1;
+    }
+    loaded = n;
     
-    // Iterate through all songs in database
-    for (int i=1; i<num_of_songs; i++) {
+    // Background thread carries on from where tokens stopped
+    loader = thread([this, tokens, n, snapName, stamp, &err]() mutable {
+        
+        row_fields row;
+        song s;
+        int line = n;
+        bool more = true;
         
-        // Lowercase of artist field
-        string artist_lower = lowercase(database[i].artist);
+        while (more) {
+            
+            // Parse next batch of lines
+            int batch_end = line + LOAD_BATCH;
+            while (line < batch_end && (more = tokens.next(row))) {
+                load_error e = parse_song(row, line, s, text_store);
+                if (e != LOAD_OK) {
+                    {
+                        lock_guard<mutex> lock(loaded_mutex);
+                        loaded.store(line, memory_order_release);
+                        load_failure.store(e, memory_order_release);
+                    }
+                    loaded_cond.notify_all();
+                    return;
+                }
+                set_row(line, s, names);
+                line_hash[line] = hash_bytes(row.first, row.last - row.first);
+                line++;
+            }
+            
+            // Publish batch
+            {
+                lock_guard<mutex> lock(loaded_mutex);
+                loaded.store(line, memory_order_release);
+            }
+            loaded_cond.notify_all();
+        }
         
-        // If key == artist, display in console and increase count by 1
-        if(artist_lower.find(key_lower) != artist_lower.npos){
-            os << database[i];
-            count++;
+        if (!snapName.empty()) {
+            save_snapshot(snapName, stamp);
         }
+    });
+}
+
+/* Waits on loaded_cond until the background load has published songid, or
+    has stopped at an invalid line before it
+ */
+void song_database::wait_for(int songid) const {
+    if (songid < loaded.load(memory_order_acquire)) {
+        return;
     }
+    
+    unique_lock<mutex> lock(loaded_mutex);
+    while (songid >= loaded.load(memory_order_acquire) && load_failure.load(memory_order_acquire) == LOAD_OK) {
+        loaded_cond.wait(lock);
+    }
+}
 
-    return count;
+/* Turns trigram indexes on. They are built when they are first needed. */
+void song_database::use_search_index() {
+    search_index = true;
 }
 
-/* Displays songs containing key string as a substring of the title field.
-    Compares lowercase versions of both key and title field to make search case
-    insensitive. Returns number of times key was found as substring.
+/* Folds every title and every artist in the artist dictionary into
+    folded_titles and folded_artists.
  */
-const int song_database::display_songs_by_title(string &key) const{
+bool song_database::folded_columns_ready() const {
     
-    // Number of times key is found as substring
-    int count = 0;
+    // Songs still loading would be left out of the columns
+    if (is_loading()) {
+        return false;
+    }
     
-    // Lowercase version of key
-    string key_lower = lowercase(key);
+    if (folded_built) {
+        return true;
+    }
     
-    // Iterate through database
-    for (int i=1; i<=num_of_songs; i++) {
-        
-        // Lowercase version of title
-        string title_lower = lowercase(database[i].title);
-        
-        // If key == title, display in console and increase count by 1
-        if(title_lower.find(key_lower) != title_lower.npos){
-            os << database[i];
-            count++;
+    folded_titles.clear();
+    for (size_t i=0; i<rows(); i++) {
+        folded_titles.add(titles[i]);
+    }
+    
+    folded_artists.clear();
+    for (uint32_t id=0; id<names.artists.size(); id++) {
+        folded_artists.add(names.artists[id]);
+    }
+    
+    folded_built = true;
+    return true;
+}
+
+/* Builds trigram indexes of every artist in the artist dictionary and of
+    every title, then sorts rows by artist id, counting the rows of each
+    artist first so each one's rows can be placed straight into artist_rows
+    in order. Field headers at row 0 are left out of artist_rows.
+ */
+bool song_database::search_index_ready() const {
+    
+    // Songs still loading would be left out of the indexes. Candidates are
+    // checked against the folded columns.
+    if (!search_index || !folded_columns_ready()) {
+        return false;
+    }
+    
+    if (search_index_built) {
+        return true;
+    }
+    
+    artist_trigrams.clear();
+    for (uint32_t id=0; id<names.artists.size(); id++) {
+        artist_trigrams.add(names.artists[id]);
+    }
+    
+    title_trigrams.clear();
+    for (size_t i=0; i<rows(); i++) {
+        title_trigrams.add(titles[i]);
+    }
+    
+    // Number of rows of each artist, then where each artist's rows start
+    artist_row_first.assign(names.artists.size() + 1, 0);
+    for (size_t i=1; i<rows(); i++) {
+        artist_row_first[artist_ids[i] + 1]++;
+    }
+    for (uint32_t id=0; id<names.artists.size(); id++) {
+        artist_row_first[id + 1] += artist_row_first[id];
+    }
+    
+    artist_rows.resize(artist_row_first.back());
+    vector<uint32_t> next(artist_row_first.begin(), artist_row_first.end() - 1);
+    for (size_t i=1; i<rows(); i++) {
+        artist_rows[next[artist_ids[i]]++] = (uint32_t)i;
+    }
+    
+    search_index_built = true;
+    return true;
+}
+
+/* Sorts song IDs by year, time and size. Field headers at row 0 are left
+    out.
+ */
+bool song_database::numeric_index_ready() const {
+    
+    // Songs still loading would be left out of the indexes
+    if (!search_index || is_loading()) {
+        return false;
+    }
+    
+    if (numeric_index_built) {
+        return true;
+    }
+    
+    uint32_t first = rows() > 0 ? 1 : 0;
+    year_index.build(years, first, (uint32_t)rows());
+    time_index.build(times, first, (uint32_t)rows());
+    size_index.build(sizes, first, (uint32_t)rows());
+    
+    numeric_index_built = true;
+    return true;
+}
+
+/* Returns year_index, time_index or size_index */
+const sorted_index & song_database::numeric_index(query_field field) const {
+    return field == QUERY_YEAR ? year_index : field == QUERY_TIME ? time_index : size_index;
+}
+
+/* Counts the rows with each id in the artist, album and genre id columns.
+    Field headers at row 0 are not a song.
+ */
+bool song_database::name_songs_ready() const {
+    
+    // Songs still loading would be left out of the counts
+    if (is_loading()) {
+        return false;
+    }
+    
+    if (name_songs_built) {
+        return true;
+    }
+    
+    artist_songs.assign(names.artists.size(), 0);
+    album_songs.assign(names.albums.size(), 0);
+    genre_songs.assign(names.genres.size(), 0);
+    for (size_t i=1; i<rows(); i++) {
+        artist_songs[artist_ids[i]]++;
+        album_songs[album_ids[i]]++;
+        genre_songs[genre_ids[i]]++;
+    }
+    
+    name_songs_built = true;
+    return true;
+}
+
+/* Indexes folded artists and titles, leaving out field headers at row 0 of
+    the title column.
+ */
+void song_database::fuzzy_index_ready() const {
+    
+    wait_for(num_of_songs);
+    folded_columns_ready();
+    name_songs_ready();
+    
+    if (fuzzy_built) {
+        return;
+    }
+    
+    fuzzy_artists.build(folded_artists, 0, folded_artists.size());
+    fuzzy_titles.build(folded_titles, rows() > 0 ? 1 : 0, folded_titles.size());
+    
+    fuzzy_built = true;
+}
+
+/* Indexes folded artists that have songs and every folded title, leaving
+    out field headers at row 0.
+ */
+void song_database::prefix_index_ready() const {
+    
+    wait_for(num_of_songs);
+    folded_columns_ready();
+    name_songs_ready();
+    
+    if (prefix_built) {
+        return;
+    }
+    
+    vector<uint32_t> ids;
+    for (uint32_t id=0; id<names.artists.size(); id++) {
+        if (artist_songs[id] > 0) {
+            ids.push_back(id);
         }
     }
+    artist_prefixes.build(folded_artists, ids);
+    
+    ids.clear();
+    for (size_t i=1; i<rows(); i++) {
+        ids.push_back((uint32_t)i);
+    }
+    title_prefixes.build(folded_titles, ids);
+    
+    prefix_built = true;
+}
+
+/* Uses as many threads as asked, or one per core */
+void song_database::use_search_threads(int threads) {
+    if (threads < 1) {
+        threads = thread::hardware_concurrency();
+    }
+    search_threads = threads < 1 ? 1 : threads;
+}
+
+/* Read by song_writer for every song written */
+void song_database::use_output_format(output_format f) {
+    output = f;
+}
+
+output_format song_database::get_output_format() const { return output; }
+
+/* One part per search thread, but no part smaller than MIN_SEARCH_PART_ROWS */
+int song_database::search_parts(uint32_t first, uint32_t last) const {
+    if (last <= first) {
+        return 1;
+    }
+    
+    uint32_t parts = (last - first) / MIN_SEARCH_PART_ROWS;
+    if (parts > (uint32_t)search_threads) {
+        parts = search_threads;
+    }
+    return parts < 1 ? 1 : (int)parts;
+}
+
+/* Splits rows first up to last into search_parts equal parts and runs work on
+    each, one thread per part. A single part is run on the calling thread.
+ */
+void song_database::run_parts(uint32_t first, uint32_t last, const function<void(int, uint32_t, uint32_t)> &work) const {
+    
+    int parts = search_parts(first, last);
+    if (parts == 1) {
+        work(0, first, last > first ? last : first);
+        return;
+    }
+    
+    uint64_t n = last - first;
+    vector<thread> workers;
+    for (int p=0; p<parts; p++) {
+        uint32_t from = first + (uint32_t)(n * p / parts);
+        uint32_t to = first + (uint32_t)(n * (p + 1) / parts);
+        workers.push_back(thread(work, p, from, to));
+    }
+    for (int p=0; p<parts; p++) {
+        workers[p].join();
+    }
+}
+
+/* Appends each part's song IDs in part order. Parts cover rows in order, so
+    song IDs stay in order.
+ */
+void song_database::join_parts(vector< vector<uint32_t> > &parts, vector<uint32_t> &ids) {
+    
+    size_t total = ids.size();
+    for (size_t p=0; p<parts.size(); p++) {
+        total += parts[p].size();
+    }
+    ids.reserve(total);
+    
+    for (size_t p=0; p<parts.size(); p++) {
+        ids.insert(ids.end(), parts[p].begin(), parts[p].end());
+    }
+}
+
+/* Writes songs through a song_writer, a block at a time, or, if there are
+    enough of them to split between search threads, has each thread format
+    its share into a buffer of its own and writes the buffers to &os in
+    order.
+ */
+void song_database::write_songs(const vector<uint32_t> &ids) const {
+    
+    int parts = search_parts(0, (uint32_t)ids.size());
+    if (parts == 1) {
+        song_writer writer(os, output);
+        for (size_t i=0; i<ids.size(); i++) {
+            writer.write(song_at(ids[i]));
+        }
+        writer.flush();
+        return;
+    }
+    
+    vector<string> buffers(parts);
+    run_parts(0, (uint32_t)ids.size(), [&](int part, uint32_t from, uint32_t to) {
+        for (uint32_t i=from; i<to; i++) {
+            song_writer::format(song_at(ids[i]), buffers[part], output);
+        }
+    });
+    
+    for (int p=0; p<parts; p++) {
+        os.write(buffers[p].data(), buffers[p].size());
+    }
+    os.flush();
+}
+
+/* Writes number of songs results were taken from, and what percentage of the
+    database that is, if a progressive load is still running.
+ */
+void song_database::report_progress(int ready) const {
+    if (ready >= num_of_songs) {
+        return;
+    }
+    
+    os << "(Still loading: results are from the first " << ready << " of " << num_of_songs << " songs, " << (num_of_songs > 0 ? (long long)ready * 100 / num_of_songs : 100) << "% loaded so far.)" << endl;
+}
+
+/* Splits line n into fields and adds it to the end of database with
+    parse_song. If line is invalid, writes errors to error stream and exits
+    with error code -1.
+ */
+void song_database::add_song(const char *first, const char *last, int n, ostream &err) {
+    
+    // An empty line is still a line, with no fields
+    row_tokenizer tokens(first, last);
+    row_fields r;
+    if (!tokens.next(r)) {
+        r.first = r.last = first;
+        r.count = 0;
+    }
+    
+    song s;
+    load_error e = parse_song(r, n, s, text_store);
+    if (e != LOAD_OK) {
+        report_load_error(e, err);
+    }
+    
+    // Add s as last song in database
+    resize_rows(rows() + 1);
+    set_row(n, s, names);
+    line_hash[n] = hash_bytes(first, last - first);
+}
+
+/* Returns number of rows in title column. Every column has as many. */
+size_t song_database::rows() const { return titles.size(); }
+
+/* Resizes each column in turn */
+void song_database::resize_rows(size_t n) {
+    titles.resize(n);
+    artist_ids.resize(n);
+    album_ids.resize(n);
+    genre_ids.resize(n);
+    sizes.resize(n);
+    times.resize(n);
+    years.resize(n);
+    comments.resize(n);
+    line_hash.resize(n);
+}
+
+/* Copies each field of s to its column, interning names. Time is put back
+    together into seconds.
+ */
+void song_database::set_row(int n, const song &s, name_dictionaries &d) {
+    titles[n] = s.title;
+    artist_ids[n] = d.artists.intern(s.artist);
+    album_ids[n] = d.albums.intern(s.album);
+    genre_ids[n] = d.genres.intern(s.genre);
+    sizes[n] = s.size;
+    times[n] = s.time_mins*60 + s.time_secs;
+    years[n] = s.year;
+    comments[n] = s.comments;
+}
+
+/* Fills in a song from row n of every column, looking names up in the
+    dictionaries.
+ */
+song song_database::song_at(int n) const {
+    song s;
+    s.id = n;
+    s.title = titles[n];
+    s.artist = names.artists[artist_ids[n]];
+    s.album = names.albums[album_ids[n]];
+    s.genre = names.genres[genre_ids[n]];
+    s.size = sizes[n];
+    s.time_mins = times[n]/60;
+    s.time_secs = times[n]%60;
+    s.year = years[n];
+    s.comments = comments[n];
+    return s;
+}
+
+/* Checks a single line of the songs file, already split into fields by a
+    row_tokenizer, for validity: whether it contains 8 tab delimited fields,
+    whether any field is empty, whether headers are valid if it is the first
+    line and whether the song contains a non-empty artist and title field. 
+    Enclosing double quotes (") have already been removed by the tokenizer;
+    fields with quotes inside them are copied without them. Reads numeric
+    fields in as integers. Returns the first problem found with the line, if
+    any.
+ */
+song_database::load_error song_database::parse_song(const row_fields &r, int n, song &s, list<string> &store) {
+    
+    string_view song_fields[8];
+    
+    // Checks the number of fields in line
+    // If a line doesn't contain 8 fields, file is invalid
+    if (r.count != 8) {
+        return LOAD_FIELD_COUNT;
+    }
+    
+    // Checks if one or more of the song fields in current line is empty
+    // If so, file is invalid.
+    for (int i=0; i<8; i++){
+        if (r.raw[i].empty()) {
+            return LOAD_EMPTY_FIELD;
+        }
+        
+        // Remove double quotes from all fields
+        song_fields[i] = r.inner_quotes[i] ? strip_quotes(r.text[i], store) : r.text[i];
+    }
+
+    // We are at the first line in the file. Must verify headings are
+    // correct.
+    if (n == 0) {
+        if (song_fields[0] != "Name" || song_fields[1] != "Artist" || song_fields[2] != "Album" || song_fields[3] != "Genre" || song_fields[4] != "Size" || song_fields[5] != "Time" || song_fields[6] != "Year" || song_fields[7] != "Comments") {
+            return LOAD_BAD_HEADER;
+        }
+        
+    }
+    // We have passed the first line in the file.
+    // Rest of lines in file now contain song data.
+    
+    // Check to see if Name or Artist field is empty
+    if (song_fields[0].empty() || song_fields[1].empty()) {
+        return LOAD_NO_NAME_ARTIST;
+    }
+    
+    // Populate song from fields read into song_fields
+    // Song id is determined by what line in the file we're on
+    s.id = n;
+    s.title = song_fields[0];
+    s.artist = song_fields[1];
+    s.album = song_fields[2];
+    s.genre = song_fields[3];
+    
+    // Must pass s.size, s.time and s.year as integers, not strings
+    s.size = to_int(song_fields[4]);
+    
+    // Convert time in seconds to mins and secs
+    int time = to_int(song_fields[5]);
+    s.time_mins = time/60;
+    s.time_secs = time%60;
+    
+    s.year = to_int(song_fields[6]);
+    
+    s.comments = song_fields[7];
+    
+    return LOAD_OK;
+}
+
+/* Checks that snapshot file is well formed, is the size its header says it
+    is and was made from a songs file with the same size, modification time and
+    contents hash as the current one. If so, copies the number columns and
+    rebuilds the text columns and dictionaries from the text lists, pointing
+    them into the blob. Offsets and ids are checked as they are read so that a
+    damaged snapshot can't point outside the mapping.
+ */
+bool song_database::load_snapshot(const string &snapName, const source_stamp &stamp) {
+    
+    if (!snapshot.open(snapName) || snapshot.size() < sizeof(snapshot_header)) {
+        snapshot.close();
+        return false;
+    }
+    
+    snapshot_header h;
+    memcpy(&h, snapshot.begin(), sizeof(h));
+    
+    // Snapshot was made from some other version of the songs file
+    if (memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) != 0 || h.source_size != stamp.size || h.source_mtime != stamp.mtime || h.source_hash != stamp.hash) {
+        snapshot.close();
+        return false;
+    }
+    
+    // A name can't be in more rows than there are
+    if (h.rows > snapshot.size() || h.names[0] > h.rows || h.names[1] > h.rows || h.names[2] > h.rows) {
+        snapshot.close();
+        return false;
+    }
+    
+    uint64_t column_bytes = snapshot_column_bytes(h.rows);
+    uint64_t offsets_bytes = snapshot_offsets_bytes(h);
+    uint64_t line_hash_bytes = h.rows * sizeof(uint64_t);
+    if (sizeof(h) + 2 * column_bytes + line_hash_bytes + offsets_bytes + h.blob_size != snapshot.size()) {
+        snapshot.close();
+        return false;
+    }
+    
+    const char *p = snapshot.begin() + sizeof(h);
+    const int32_t *ints = reinterpret_cast<const int32_t *>(p);
+    p += column_bytes;
+    
+    const uint64_t *hashes = reinterpret_cast<const uint64_t *>(p);
+    p += line_hash_bytes;
+    
+    const uint32_t *ids = reinterpret_cast<const uint32_t *>(p);
+    p += column_bytes;
+    
+    const uint32_t *offsets = reinterpret_cast<const uint32_t *>(p);
+    const char *blob = p + offsets_bytes;
+    
+    // Number columns are copied as they are
+    sizes.assign(ints, ints + h.rows);
+    times.assign(ints + h.rows, ints + 2*h.rows);
+    years.assign(ints + 2*h.rows, ints + 3*h.rows);
+    line_hash.assign(hashes, hashes + h.rows);
+    artist_ids.assign(ids, ids + h.rows);
+    album_ids.assign(ids + h.rows, ids + 2*h.rows);
+    genre_ids.assign(ids + 2*h.rows, ids + 3*h.rows);
+    titles.resize(h.rows);
+    comments.resize(h.rows);
+    
+    uint64_t list_sizes[SNAPSHOT_TEXT_LISTS];
+    snapshot_list_sizes(h, list_sizes);
+    string_dictionary *dictionaries[3] = {&names.artists, &names.albums, &names.genres};
+    
+    bool ok = true;
+    const uint32_t *list = offsets;
+    for (int l=0; l<SNAPSHOT_TEXT_LISTS && ok; l++) {
+        for (uint64_t i=0; i<list_sizes[l] && ok; i++) {
+            
+            if (list[i] > list[i+1] || list[i+1] > h.blob_size) {
+                ok = false;
+                break;
+            }
+            string_view text(blob + list[i], list[i+1] - list[i]);
+            
+            if (l == 0) {
+                titles[i] = text;
+            }
+            else if (l == 1) {
+                comments[i] = text;
+            }
+            
+            // Names were written in id order, and each only once
+            else if (dictionaries[l-2]->intern(text) != i) {
+                ok = false;
+            }
+        }
+        list += list_sizes[l] + 1;
+    }
+    
+    // Every id must name something in its dictionary
+    for (uint64_t i=0; i<h.rows && ok; i++) {
+        ok = artist_ids[i] < h.names[0] && album_ids[i] < h.names[1] && genre_ids[i] < h.names[2];
+    }
+    
+    if (!ok) {
+        resize_rows(0);
+        names.artists.clear();
+        names.albums.clear();
+        names.genres.clear();
+        snapshot.close();
+        return false;
+    }
+    
+    return true;
+}
+
+/* Returns string i of text list l of the database, in the order lists are
+    stored in a snapshot.
+ */
+string_view song_database::snapshot_text(int l, uint32_t i) const {
+    switch (l) {
+        case 0: return titles[i];
+        case 1: return comments[i];
+        case 2: return names.artists[i];
+        case 3: return names.albums[i];
+        default: return names.genres[i];
+    }
+}
+
+/* Writes every column and text list in database to a temporary snapshot file,
+    then renames it to snapName. If anything goes wrong, the temporary file is
+    removed and no snapshot is left behind.
+ */
+void song_database::save_snapshot(const string &snapName, const source_stamp &stamp) const {
+    
+    uint64_t num_rows = rows();
+    
+    snapshot_header h;
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.source_size = stamp.size;
+    h.source_mtime = stamp.mtime;
+    h.source_hash = stamp.hash;
+    h.rows = num_rows;
+    h.names[0] = names.artists.size();
+    h.names[1] = names.albums.size();
+    h.names[2] = names.genres.size();
+    h.blob_size = 0;
+    
+    // Number columns, padded to a multiple of 8 bytes
+    vector<int32_t> ints(snapshot_column_bytes(num_rows) / sizeof(int32_t), 0);
+    copy(sizes.begin(), sizes.end(), ints.begin());
+    copy(times.begin(), times.end(), ints.begin() + num_rows);
+    copy(years.begin(), years.end(), ints.begin() + 2*num_rows);
+    
+    vector<uint32_t> ids(snapshot_column_bytes(num_rows) / sizeof(uint32_t), 0);
+    copy(artist_ids.begin(), artist_ids.end(), ids.begin());
+    copy(album_ids.begin(), album_ids.end(), ids.begin() + num_rows);
+    copy(genre_ids.begin(), genre_ids.end(), ids.begin() + 2*num_rows);
+    
+    // Text offsets, laid out list by list in the blob, padded to a multiple
+    // of 8 bytes
+    uint64_t list_sizes[SNAPSHOT_TEXT_LISTS];
+    snapshot_list_sizes(h, list_sizes);
+    
+    vector<uint32_t> offsets(snapshot_offsets_bytes(h) / sizeof(uint32_t), 0);
+    size_t o = 0;
+    for (int l=0; l<SNAPSHOT_TEXT_LISTS; l++) {
+        for (uint64_t i=0; i<list_sizes[l]; i++) {
+            offsets[o++] = h.blob_size;
+            h.blob_size += snapshot_text(l, i).size();
+        }
+        offsets[o++] = h.blob_size;
+    }
+    
+    // Offsets wouldn't fit
+    if (h.blob_size > UINT32_MAX) {
+        return;
+    }
+    
+    string tmpName = snapName + ".tmp";
+    ofstream out(tmpName.c_str(), ios::binary | ios::trunc);
+    
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(ints.data()), ints.size() * sizeof(int32_t));
+    out.write(reinterpret_cast<const char *>(line_hash.data()), num_rows * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char *>(ids.data()), ids.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    for (int l=0; l<SNAPSHOT_TEXT_LISTS; l++) {
+        for (uint64_t i=0; i<list_sizes[l]; i++) {
+            string_view text = snapshot_text(l, i);
+            out.write(text.data(), text.size());
+        }
+    }
+    
+    out.close();
+    
+    if (out.fail() || rename(tmpName.c_str(), snapName.c_str()) != 0) {
+        remove(tmpName.c_str());
+    }
+}
+
+/* Returns size and modification time of fName from stat, and a hash of the
+    contents mapped by m if there is one.
+ */
+song_database::source_stamp song_database::stamp_file(const string &fName, const mapped_file *m) {
+    
+    source_stamp st = {};
+    
+    struct stat info;
+    if (stat(fName.c_str(), &info) == 0) {
+        st.size = info.st_size;
+        st.mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+        st.device = info.st_dev;
+        st.inode = info.st_ino;
+    }
+    
+    if (m != NULL) {
+        st.hash = hash_bytes(m->begin(), m->size());
+    }
+    
+    return st;
+}
+
+/* Copies s to the end of arena, which never moves as room was reserved */
+string_view song_database::keep_text(string_view s, string &arena) {
+    size_t at = arena.size();
+    arena.append(s.data(), s.size());
+    return string_view(arena.data() + at, s.size());
+}
+
+/* Names are copied once each, the first time a kept song uses them */
+uint32_t song_database::keep_name(const string_dictionary &from, uint32_t id, string_dictionary &to, vector<uint32_t> &ids, string &arena) {
+    if (ids[id] == UINT32_MAX) {
+        ids[id] = to.intern(keep_text(from[id], arena));
+    }
+    return ids[id];
+}
+
+/* Maps the current version of the songs file and walks through its lines,
+    comparing the hash of each line to the hash of the line the song with the
+    same song ID was parsed from. Only lines that don't match, or that are new,
+    are parsed, into a list of changes held aside. If the file was rewritten in
+    place, the songs loaded from its mapping can't be trusted, so every line
+    is. Nothing in the database is touched until every changed line has been
+    found valid, so an invalid file leaves the database as it was.
+    Text of unchanged songs, and the names they use, are then copied into one
+    block of text_store, sized up front, and the old text_store, the mapping
+    of the previous version of the file and any snapshot are released, as
+    nothing points into them any more. Names no longer used by any song are
+    dropped from the dictionaries along the way.
+ */
+bool song_database::reload(ostream &err) {
+    
+    // A progressive load must finish before songs can be replaced
+    if (loader.joinable()) {
+        loader.join();
+    }
+    
+    // Nothing has changed since last load
+    source_stamp current = stamp_file(source_name, NULL);
+    if (current.size == stamp.size && current.mtime == stamp.mtime) {
+        os << "Your songs file has not changed since it was loaded. \n" << endl;
+        return true;
+    }
+    
+    mapped_file fresh;
+    if (!fresh.open(source_name)) {
+        err << "ERROR: Could not open " << source_name << " file. \nYour songs were not reloaded.\n" << endl;
+        return false;
+    }
+    
+    // Songs still mapped from a file since rewritten in place point at its
+    // new contents, if anything
+    bool in_place = source.begin() != NULL && current.device == stamp.device && current.inode == stamp.inode;
+    
+    // Lines that were added or changed
+    vector<int> changed_ids;
+    vector<song> changed_songs;
+    vector<uint64_t> changed_hashes;
+    list<string> changed_store;
+    
+    // Lines that differ from the line their song was parsed from, which is
+    // fewer than were parsed if every line was
+    int changed = 0;
+    
+    row_tokenizer tokens(fresh.begin(), fresh.end());
+    row_fields r;
+    int n = 0;
+    
+    while (tokens.next(r)) {
+        
+        uint64_t h = hash_bytes(r.first, r.last - r.first);
+        
+        // Line is new or has changed. Parse it.
+        if (in_place || n >= (int)line_hash.size() || h != line_hash[n]) {
+            song s;
+            load_error e = parse_song(r, n, s, changed_store);
+            if (e != LOAD_OK) {
+                write_load_error(e, err);
+                err << "Your songs were not reloaded.\n" << endl;
+                return false;
+            }
+            changed_ids.push_back(n);
+            changed_songs.push_back(s);
+            changed_hashes.push_back(h);
+            if (n < (int)line_hash.size() && h != line_hash[n]) {
+                changed++;
+            }
+        }
+        
+        n++;
+    }
+    
+    int old_rows = (int)rows();
+    int removed = old_rows > n ? old_rows - n : 0;
+    int added = n > old_rows ? n - old_rows : 0;
+    
+    // Rows kept as they are: rows before the first line past the end of the
+    // old file that aren't changed. changed_ids is in order.
+    int kept_rows = old_rows < n ? old_rows : n;
+    vector<bool> kept(kept_rows, true);
+    for (size_t i=0; i<changed_ids.size() && changed_ids[i] < kept_rows; i++) {
+        kept[changed_ids[i]] = false;
+    }
+    
+    // Room for the text of every kept song and every name
+    size_t kept_bytes = 0;
+    for (int row=0; row<kept_rows; row++) {
+        if (kept[row]) {
+            kept_bytes += titles[row].size() + comments[row].size();
+        }
+    }
+    const string_dictionary *old_dicts[3] = { &names.artists, &names.albums, &names.genres };
+    for (int d=0; d<3; d++) {
+        for (uint32_t id=0; id<old_dicts[d]->size(); id++) {
+            kept_bytes += (*old_dicts[d])[id].size();
+        }
+    }
+    
+    list<string> kept_store;
+    kept_store.push_back(string());
+    string &arena = kept_store.back();
+    arena.reserve(kept_bytes);
+    
+    name_dictionaries kept_names;
+    kept_names.artists.reserve(n);
+    kept_names.albums.reserve(n);
+    kept_names.genres.reserve(n);
+    vector<uint32_t> artist_map(names.artists.size(), UINT32_MAX);
+    vector<uint32_t> album_map(names.albums.size(), UINT32_MAX);
+    vector<uint32_t> genre_map(names.genres.size(), UINT32_MAX);
+    
+    // Copy kept songs out of the old mapping and text_store
+    for (int row=0; row<kept_rows; row++) {
+        if (kept[row]) {
+            titles[row] = keep_text(titles[row], arena);
+            comments[row] = keep_text(comments[row], arena);
+            artist_ids[row] = keep_name(names.artists, artist_ids[row], kept_names.artists, artist_map, arena);
+            album_ids[row] = keep_name(names.albums, album_ids[row], kept_names.albums, album_map, arena);
+            genre_ids[row] = keep_name(names.genres, genre_ids[row], kept_names.genres, genre_map, arena);
+        }
+    }
+    
+    // Apply changes
+    resize_rows(n);
+    for (size_t i=0; i<changed_ids.size(); i++) {
+        set_row(changed_ids[i], changed_songs[i], kept_names);
+        line_hash[changed_ids[i]] = changed_hashes[i];
+    }
+    kept_store.splice(kept_store.end(), changed_store);
+    
+    // Nothing points into the old text, names or mappings any more. Fresh
+    // mapping becomes the source.
+    names = move(kept_names);
+    text_store.swap(kept_store);
+    source.swap(fresh);
+    fresh.close();
+    snapshot.close();
+    
+    num_of_songs = (int)rows()-1;
+    loaded = (int)rows();
+    load_failure = LOAD_OK;
+    search_index_built = false;
+    folded_built = false;
+    numeric_index_built = false;
+    name_songs_built = false;
+    search_results.clear();
+    fuzzy_built = false;
+    prefix_built = false;
+    stamp = stamp_file(source_name, keep_snapshot ? &source : NULL);
+    
+    if (keep_snapshot) {
+        save_snapshot(source_name + ".snapshot", stamp);
+    }
+    
+    os << "RELOADED! " << changed << " songs were changed, " << added << " songs were added and " << removed << " songs were removed. \n" << endl;
+    
+    return true;
+}
+
+/* Writes message explaining why songs file is invalid to error stream and
+    exits with error code -1.
+ */
+void song_database::report_load_error(load_error e, ostream &err) {
+    write_load_error(e, err);
+    exit(-1);
+}
+
+/* Writes message explaining why songs file is invalid to error stream */
+void song_database::write_load_error(load_error e, ostream &err) {
+    
+    if (e == LOAD_FIELD_COUNT) {
+        err << "INVALID FILE: One or more of the lines in your songs file either has missing fields, \ncontains fields not separated by single tabs or \nhas more than 8 fields.\nPlease check your file and try again. \n" << endl;
+    }
+    else if (e == LOAD_EMPTY_FIELD) {
+        err << "INVALID FILE: One or more of the lines in your songs file has missing fields or\ncontains fields not separated by single tabs.\nPlease check your file and try again. \n" << endl;
+    }
+    else if (e == LOAD_BAD_HEADER) {
+        err << "INVALID FILE: Incorrect header(s).\nPlease check your file and try again. \n" << endl;
+    }
+    else if (e == LOAD_NO_NAME_ARTIST) {
+        err << "INVALID FILE: One or more of the songs in your songs file is missing a Name and/or an Artist field. \nPlease check your file and try again. \n" << endl;
+    }
+}
+
+/* Copies field without any of its double quotes into store. Only needed for
+    fields with quotes inside them, which can't point into the line.
+ */
+string_view song_database::strip_quotes(string_view field, list<string> &store) {
+    
+    store.push_back(string());
+    string &copy = store.back();
+    copy.reserve(field.size());
+    
+    // Copy runs of characters between quotes
+    size_t from = 0;
+    while (from < field.size()) {
+        size_t quote = field.find('\"', from);
+        if (quote == field.npos) {
+            quote = field.size();
+        }
+        copy.append(field.data() + from, quote - from);
+        from = quote + 1;
+    }
+    
+    return copy;
+}
+
+/* Convert a string to lowercase*/
+string song_database::lowercase(string word) const{
+    transform(word.begin(), word.end(), word.begin(), ::tolower);
+    return word;
+}
+
+/* Returns a song from row songid of database
+    1 <= songid <= num_of_songs as the first row in the song database is
+    made up of the song headers
+ */
+song song_database::get_song(int songid) const {
+    wait_for(songid);
+    return song_at(songid);
+}
+
+
+/* Returns how many songs are in the database */
+int song_database::size() const { return num_of_songs; }
+
+
+/* Returns how many songs have been loaded. Field headers at database[0] are
+    not a song.
+ */
+int song_database::loaded_songs() const {
+    int n = loaded.load(memory_order_acquire) - 1;
+    return n < 0 ? 0 : n;
+}
+
+
+/* Returns true while a progressive load is publishing songs */
+bool song_database::is_loading() const {
+    return loaded.load(memory_order_acquire) < (int)rows();
+}
+
+
+/* Background thread has already stopped, so is joined straight away. Rows
+    it never loaded are dropped, which leaves loaded == rows().
+ */
+bool song_database::load_failed(ostream &err) {
+    
+    load_error e = (load_error)load_failure.load(memory_order_acquire);
+    if (e == LOAD_OK) {
+        return false;
+    }
+    
+    if (loader.joinable()) {
+        loader.join();
+    }
+    resize_rows(loaded.load(memory_order_acquire));
+    num_of_songs = (int)rows()-1;
+    load_failure.store(LOAD_OK, memory_order_release);
+    
+    write_load_error(e, err);
+    err << "ERROR: Loading stopped at the invalid line. Only the first " << num_of_songs << " songs were loaded.\n" << endl;
+    return true;
+}
+
+
+/* Has the search cache write its statistics */
+void song_database::display_cache_stats() const {
+    search_results.display_stats(os);
+}
+
+
+/* Displays songs from datbase[first] to databse[last]. Performs checks on first
+    and last to ensure this can be done with no out of range errors. Iterates
+    through songs in database using a for loop and displays each song using
+    overloaded << operator.
+ */
+void song_database::list_songs(int first, int last) const{
+    int after = 0;
+    list_songs(first, last, 0, SIZE_MAX, after);
+}
+
+/* Works out which song IDs are on the page from first, last and the cursor,
+    then displays them the same way. Moves the cursor to the last song
+    displayed if there are more. Returns number of songs displayed.
+ */
+int song_database::list_songs(int first, int last, size_t offset, size_t limit, int &after) const{
+    
+    // Songs loaded so far
+    int ready = loaded_songs();
+    
+    // If last > num_of_songs, only displays until database[num_of_songs]
+    if (last > num_of_songs ) { last = num_of_songs; }
+    
+    // If still loading, only displays songs loaded so far
+    if (last > ready) { last = ready; }
+    
+    // If first < 1, only displays starting at datbase[1]
+    if (first < 1) { first = 1; }
+    
+    // Page starts offset songs past the cursor
+    if (after >= first) { first = after + 1; }
+    first = (int)min<long long>((long long)first + (long long)min<size_t>(offset, INT_MAX), (long long)last + 1);
+    
+    // Page ends limit songs later
+    int end = last;
+    if (limit < (size_t)(last - first + 1)) { end = first + (int)limit - 1; }
+    
+    // Displays songs from first to end
+    song_writer writer(os, output);
+    for (int i=first; i<end+1; i++) {
+        writer.write(song_at(i));
+    }
+    writer.flush();
+    
+    after = end < last ? end : 0;
+    report_progress(ready);
+    
+    return end < first ? 0 : end - first + 1;
+}
+
+/* Finds songs by artist. Artists are compared rather than songs: each
+    distinct artist once, then songs are picked out by artist id. If searches
+    use an index, only artists the index finds are compared and only their
+    songs are visited. Else, once every song is loaded, the case folded
+    artist dictionary is scanned in a single pass and the artist id column is
+    split between search threads, a block at a time if only some songs are
+    wanted. While songs are still loading, each artist is folded as a song by
+    them is reached.
+ */
+void song_database::find_by_artist(const string &key_lower, uint32_t first, uint32_t last, size_t wanted, vector<uint32_t> &hits) const {
+    
+    // Artists that may have key in them
+    vector<uint32_t> candidates;
+    if (search_index_ready() && artist_trigrams.candidates(key_lower, candidates)) {
+        
+        // Songs of every candidate artist that does have key in them
+        for (size_t c=0; c<candidates.size(); c++) {
+            uint32_t id = candidates[c];
+            if (folded_artists.contains(id, key_lower)) {
+                hits.insert(hits.end(), artist_rows.begin() + artist_row_first[id], artist_rows.begin() + artist_row_first[id + 1]);
+            }
+        }
+        sort(hits.begin(), hits.end());
+        hits.erase(lower_bound(hits.begin(), hits.end(), last), hits.end());
+        hits.erase(hits.begin(), lower_bound(hits.begin(), hits.end(), first));
+    }
+    
+    // Every artist at once, then songs split between threads
+    else if (folded_columns_ready()) {
+        vector<char> matches(folded_artists.size(), 0);
+        folded_artists.find_all(key_lower, 0, folded_artists.size(), candidates);
+        for (size_t c=0; c<candidates.size(); c++) {
+            matches[candidates[c]] = 1;
+        }
+        
+        for (uint32_t from=first; from<last && hits.size()<wanted; ) {
+            uint32_t to = search_block_end(from, last, wanted);
+            vector< vector<uint32_t> > part_hits(search_parts(from, to));
+            run_parts(from, to, [&](int part, uint32_t part_from, uint32_t part_to) {
+                for (uint32_t i=part_from; i<part_to; i++) {
+                    if (matches[artist_ids[i]]) {
+                        part_hits[part].push_back(i);
+                    }
+                }
+            });
+            join_parts(part_hits, hits);
+            from = to;
+        }
+    }
+    
+    else {
+        
+        // Whether key is in each artist: 1 if it is, 0 if it isn't, -1 if
+        // artist hasn't been compared yet
+        vector<signed char> matches;
+        
+        // Artist folded into here
+        string artist_lower;
+        
+        // Iterate through songs in database until enough are found
+        for (uint32_t i=first; i<last && hits.size()<wanted; i++) {
+            
+            uint32_t id = artist_ids[i];
+            if (id >= matches.size()) {
+                matches.resize(id + 1, -1);
+            }
+            
+            // Lowercase of artist field
+            if (matches[id] < 0) {
+                fold_case(names.artists[id], artist_lower);
+                matches[id] = find_bytes(artist_lower.data(), artist_lower.size(), key_lower) != string_view::npos;
+            }
+            
+            // If key == artist, keep song
+            if(matches[id]){
+                hits.push_back(i);
+            }
+        }
+    }
+    
+    if (hits.size() > wanted) {
+        hits.resize(wanted);
+    }
+}
+
+/* Finds songs by title. If searches use an index, only titles the index
+    finds are compared. Else, once every song is loaded, the case folded
+    title column is split between search threads, each scanning its part in a
+    single pass, a block at a time if only some songs are wanted. While songs
+    are still loading, each title is folded as it is reached.
+ */
+void song_database::find_by_title(const string &key_lower, uint32_t first, uint32_t last, size_t wanted, vector<uint32_t> &hits) const {
+    
+    // Titles that may have key in them, in song ID order
+    vector<uint32_t> candidates;
+    if (search_index_ready() && title_trigrams.candidates(key_lower, candidates)) {
+        for (size_t c=0; c<candidates.size() && hits.size()<wanted; c++) {
+            uint32_t i = candidates[c];
+            if (i >= first && i < last && folded_titles.contains(i, key_lower)) {
+                hits.push_back(i);
+            }
+        }
+    }
+    
+    // Titles split between threads
+    else if (folded_columns_ready()) {
+        for (uint32_t from=first; from<last && hits.size()<wanted; ) {
+            uint32_t to = search_block_end(from, last, wanted);
+            vector< vector<uint32_t> > part_hits(search_parts(from, to));
+            run_parts(from, to, [&](int part, uint32_t part_from, uint32_t part_to) {
+                folded_titles.find_all(key_lower, part_from, part_to, part_hits[part]);
+            });
+            join_parts(part_hits, hits);
+            from = to;
+        }
+    }
+    
+    else {
+        
+        // Title folded into here
+        string title_lower;
+        
+        // Iterate through database until enough are found
+        for (uint32_t i=first; i<last && hits.size()<wanted; i++) {
+            
+            // Lowercase version of title
+            fold_case(titles[i], title_lower);
+            
+            // If key == title, keep song
+            if(find_bytes(title_lower.data(), title_lower.size(), key_lower) != string_view::npos){
+                hits.push_back(i);
+            }
+        }
+    }
+    
+    if (hits.size() > wanted) {
+        hits.resize(wanted);
+    }
+}
+
+/* Every song left if every song found is wanted, else enough for each search
+    thread to scan a part of the smallest size worth a thread
+ */
+uint32_t song_database::search_block_end(uint32_t from, uint32_t last, size_t wanted) const {
+    if (wanted == SIZE_MAX) {
+        return last;
+    }
+    
+    uint64_t block = (uint64_t)MIN_SEARCH_PART_ROWS * search_threads;
+    return (uint32_t)min<uint64_t>(last, from + block);
+}
+
+/* Takes the page from a cached search of every song if there is one. Else,
+    once every song is loaded, the first page is taken from a search of every
+    song, which is cached so that later pages and repeats of the search are
+    taken from it too. Any other page is searched for from the song after the
+    cursor, stopping once the page and one song past it are found, so that
+    whether there are more songs is known.
+ */
+bool song_database::search_page(query_field field, const string &key_lower, bool loading, uint32_t last, size_t offset, size_t limit, int after, vector<uint32_t> &page) const {
+    
+    page.clear();
+    uint32_t first = after < 1 ? 1 : (uint32_t)after + 1;
+    
+    // Songs found after the cursor, and where they start
+    vector<uint32_t> hits;
+    const vector<uint32_t> *found = loading ? NULL : search_results.find(field, key_lower);
+    size_t start = 0;
+    
+    if (found != NULL) {
+        start = lower_bound(found->begin(), found->end(), first) - found->begin();
+    }
+    else {
+        // Whole search is kept for the first page, so it can be cached
+        bool keep = !loading && first == 1 && offset == 0;
+        size_t wanted = SIZE_MAX;
+        if (!keep && limit < SIZE_MAX && offset < SIZE_MAX - limit - 1) {
+            wanted = offset + limit + 1;
+        }
+        if (field == QUERY_ARTIST) {
+            find_by_artist(key_lower, first, last, wanted, hits);
+        }
+        else {
+            find_by_title(key_lower, first, last, wanted, hits);
+        }
+        
+        if (!loading && first == 1 && wanted == SIZE_MAX) {
+            search_results.insert(field, key_lower, hits);
+        }
+        found = &hits;
+    }
+    
+    start = min(start + offset, found->size());
+    size_t end = start + min(limit, found->size() - start);
+    page.assign(found->begin() + start, found->begin() + end);
+    
+    return end < found->size();
+}
+
+/* Displays songs containing key string as a substring of the artist field.
+    Compares lowercase versions of both key and artist field to make search case
+    insensitive. Matching songs are gathered first, then displayed in song ID
+    order. Returns number of times key was found as substring
+ */
+int song_database::display_songs_by_artist(string &key) const{
+    int after = 0;
+    return display_songs_by_artist(key, 0, SIZE_MAX, after);
+}
+
+/* Finds the page of songs with search_page, displays it and moves the
+    cursor to its last song if there are more. Every loaded song is searched,
+    up to and including the last, the same as title searches and queries.
+    Returns number of songs displayed.
+ */
+int song_database::display_songs_by_artist(string &key, size_t offset, size_t limit, int &after) const{
+    
+    // Lowercase version of key
+    string key_lower = lowercase(key);
+    
+    // Songs loaded so far
+    bool loading = is_loading();
+    int ready = loaded_songs();
+    
+    // Song IDs of songs on page, in order
+    vector<uint32_t> page;
+    bool more = search_page(QUERY_ARTIST, key_lower, loading, (uint32_t)ready + 1, offset, limit, after, page);
+    after = more ? (int)page.back() : 0;
+    
+    // Display in console
+    write_songs(page);
+    report_progress(ready);
+
+    return (int)page.size();
+}
+
+/* Displays songs containing key string as a substring of the title field.
+    Compares lowercase versions of both key and title field to make search case
+    insensitive. Matching songs are gathered first, then displayed in song ID
+    order. Returns number of times key was found as substring.
+ */
+int song_database::display_songs_by_title(string &key) const{
+    int after = 0;
+    return display_songs_by_title(key, 0, SIZE_MAX, after);
+}
+
+/* Finds the page of songs with search_page, displays it and moves the
+    cursor to its last song if there are more. Returns number of songs
+    displayed.
+ */
+int song_database::display_songs_by_title(string &key, size_t offset, size_t limit, int &after) const{
+    
+    // Lowercase version of key
+    string key_lower = lowercase(key);
+    
+    // Songs loaded so far
+    bool loading = is_loading();
+    int ready = loaded_songs();
+    
+    // Song IDs of songs on page, in order
+    vector<uint32_t> page;
+    bool more = search_page(QUERY_TITLE, key_lower, loading, (uint32_t)ready + 1, offset, limit, after, page);
+    after = more ? (int)page.back() : 0;
+    
+    // Display in console
+    write_songs(page);
+    report_progress(ready);
+    
+    return (int)page.size();
+}
+
+/* Searches the same songs display_songs_by_artist and display_songs_by_title
+    do, through search_page, for one page holding every song found.
+ */
+int song_database::find_songs(query_field field, string &key, vector<uint32_t> &ids) const {
+    
+    string key_lower = lowercase(key);
+    bool loading = is_loading();
+    int ready = loaded_songs();
+    search_page(field, key_lower, loading, (uint32_t)ready + 1, 0, SIZE_MAX, 0, ids);
+    
+    return (int)ids.size();
+}
+
+/* Displays artists and titles closest to key. Artists and titles that differ
+    only in case are found as one. Every artist close enough is looked at, so
+    that artists left without songs by a reload can be skipped, then the first
+    k with songs are displayed, each by the spelling of its first artist with
+    songs. Songs of each title are displayed in song ID order. Returns number
+    of artists and titles displayed.
+ */
+int song_database::display_closest(string &key, int k) const{
+    
+    // Lowercase version of key
+    string key_lower = lowercase(key);
+    
+    // One edit allowed, plus one for every 4 characters of key
+    int max_edits = min((int)FUZZY_MAX_EDITS, (int)key_lower.size() / 4 + 1);
+    
+    fuzzy_index_ready();
+    
+    // Artists close to key, closest first
+    vector<fuzzy_match> matches;
+    fuzzy_artists.closest(key_lower, max_edits, folded_artists.size(), matches);
+    
+    int shown = 0;
+    vector<uint32_t> ids;
+    for (size_t m=0; m<matches.size() && shown<k; m++) {
+        
+        // Songs by every artist with this name, and the first such artist
+        ids.clear();
+        fuzzy_artists.ids_of(matches[m].name, ids);
+        uint32_t songs = 0;
+        uint32_t first = (uint32_t)ids.size();
+        for (size_t a=0; a<ids.size(); a++) {
+            songs += artist_songs[ids[a]];
+            if (first == ids.size() && artist_songs[ids[a]] > 0) {
+                first = (uint32_t)a;
+            }
+        }
+        if (songs == 0) {
+            continue;
+        }
+        
+        if (shown == 0) {
+            os << "Artists closest to '" << key << "':" << endl;
+        }
+        os << names.artists[ids[first]] << " (" << songs << (songs == 1 ? " song)" : " songs)") << endl;
+        shown++;
+    }
+    
+    // Titles close to key, closest first, and their songs
+    fuzzy_titles.closest(key_lower, max_edits, k, matches);
+    
+    ids.clear();
+    for (size_t m=0; m<matches.size(); m++) {
+        fuzzy_titles.ids_of(matches[m].name, ids);
+    }
+    
+    if (!matches.empty()) {
+        os << (shown > 0 ? "\n" : "") << "Titles closest to '" << key << "':" << endl;
+        write_songs(ids);
+    }
+    
+    return shown + (int)matches.size();
+}
+
+/* Looks up lowercase prefix in the artist prefix index and returns the
+    artists it finds from the artist dictionary.
+ */
+void song_database::artist_completions(const string &prefix, int n, vector<string_view> &found) const{
+    
+    prefix_index_ready();
+    
+    vector<uint32_t> ids;
+    artist_prefixes.complete(lowercase(prefix), n < 0 ? 0 : n, ids);
+    
+    found.clear();
+    for (size_t i=0; i<ids.size(); i++) {
+        found.push_back(names.artists[ids[i]]);
+    }
+}
+
+/* Looks up lowercase prefix in the title prefix index and returns the
+    titles it finds from the title column.
+ */
+void song_database::title_completions(const string &prefix, int n, vector<string_view> &found) const{
+    
+    prefix_index_ready();
+    
+    vector<uint32_t> ids;
+    title_prefixes.complete(lowercase(prefix), n < 0 ? 0 : n, ids);
+    
+    found.clear();
+    for (size_t i=0; i<ids.size(); i++) {
+        found.push_back(titles[ids[i]]);
+    }
+}
+
+/* Displays artist completions, then title completions, each under a heading
+    of its own if there are any. Returns number displayed.
+ */
+int song_database::display_completions(string &prefix, int n) const{
+    
+    vector<string_view> artists_found;
+    artist_completions(prefix, n, artists_found);
+    
+    vector<string_view> titles_found;
+    title_completions(prefix, n, titles_found);
+    
+    if (!artists_found.empty()) {
+        os << "Artists starting with '" << prefix << "':" << endl;
+        for (size_t i=0; i<artists_found.size(); i++) {
+            os << artists_found[i] << endl;
+        }
+    }
+    
+    if (!titles_found.empty()) {
+        os << (artists_found.empty() ? "" : "\n") << "Titles starting with '" << prefix << "':" << endl;
+        for (size_t i=0; i<titles_found.size(); i++) {
+            os << titles_found[i] << endl;
+        }
+    }
+    
+    return (int)(artists_found.size() + titles_found.size());
+}
+
+/* Works out how selective and how costly t is. Artist, album and genre terms
+    are compared against every name in their dictionary once, and once
+    every song is loaded, the songs with the names that match are counted
+    exactly. Titles and artists can be listed by the search indexes. Other
+    terms are guessed at.
+ */
+void song_database::plan_filter(const query_term &t, query_filter &f) const {
+    
+    f.term = &t;
+    f.indexed = false;
+    f.exact = false;
+    f.index_size = 0;
+    f.candidates.clear();
+    f.names.clear();
+    
+    double songs = num_of_songs > 0 ? num_of_songs : 1;
+    
+    if (t.field == QUERY_ARTIST || t.field == QUERY_ALBUM || t.field == QUERY_GENRE) {
+        f.cost = QUERY_NAME_COST;
+        f.selectivity = QUERY_TEXT_SELECTIVITY;
+        
+        // Names still loading are compared as songs with them are reached
+        if (is_loading()) {
+            return;
+        }
+        
+        const string_dictionary &d = t.field == QUERY_ARTIST ? names.artists : t.field == QUERY_ALBUM ? names.albums : names.genres;
+        const vector<uint32_t> &counts = t.field == QUERY_ARTIST ? artist_songs : t.field == QUERY_ALBUM ? album_songs : genre_songs;
+        
+        name_songs_ready();
+        
+        string name_lower;
+        size_t matched = 0;
+        f.names.resize(d.size());
+        for (uint32_t id=0; id<d.size(); id++) {
+            fold_case(d[id], name_lower);
+            f.names[id] = find_bytes(name_lower.data(), name_lower.size(), t.key_lower) != string_view::npos;
+            if (f.names[id]) {
+                matched += counts[id];
+            }
+        }
+        
+        f.selectivity = matched / songs;
+        if (t.field == QUERY_ARTIST && search_index_ready()) {
+            f.indexed = true;
+            f.exact = true;
+            f.index_size = matched;
+        }
+    }
+    
+    else if (t.field == QUERY_TITLE) {
+        f.cost = folded_columns_ready() ? QUERY_FOLDED_TEXT_COST : QUERY_TEXT_COST;
+        f.selectivity = QUERY_TEXT_SELECTIVITY;
+        
+        if (search_index_ready() && title_trigrams.candidates(t.key_lower, f.candidates)) {
+            f.indexed = true;
+            f.index_size = f.candidates.size();
+            f.selectivity = f.candidates.size() / songs;
+        }
+    }
+    
+    else if (t.field == QUERY_COMMENTS) {
+        f.cost = QUERY_TEXT_COST;
+        f.selectivity = QUERY_TEXT_SELECTIVITY;
+    }
+    
+    else {
+        f.cost = QUERY_NUMBER_COST;
+        f.selectivity = t.low > t.high ? 0 : t.low == t.high ? QUERY_EQUAL_SELECTIVITY : QUERY_RANGE_SELECTIVITY;
+        
+        if (numeric_index_ready()) {
+            size_t first, last;
+            numeric_index(t.field).range(t.low, t.high, first, last);
+            f.indexed = true;
+            f.exact = true;
+            f.index_size = last - first;
+            f.selectivity = f.index_size / songs;
+        }
+    }
+}
+
+/* Songs of every matching artist from artist_rows, title candidates from
+    the trigram index, or songs in range from a numeric index, sorted. Field
+    headers at row 0 are left out.
+ */
+void song_database::index_rows(const query_filter &f, uint32_t last, vector<uint32_t> &ids) const {
+    
+    ids.clear();
+    
+    if (f.term->field == QUERY_ARTIST) {
+        for (uint32_t id=0; id<f.names.size(); id++) {
+            if (f.names[id] > 0) {
+                ids.insert(ids.end(), artist_rows.begin() + artist_row_first[id], artist_rows.begin() + artist_row_first[id + 1]);
+            }
+        }
+        sort(ids.begin(), ids.end());
+    }
+    else if (f.term->field == QUERY_TITLE) {
+        for (size_t c=0; c<f.candidates.size(); c++) {
+            if (f.candidates[c] >= 1) {
+                ids.push_back(f.candidates[c]);
+            }
+        }
+    }
+    else {
+        size_t first, end;
+        const sorted_index &index = numeric_index(f.term->field);
+        index.range(f.term->low, f.term->high, first, end);
+        index.rows(first, end, ids);
+        sort(ids.begin(), ids.end());
+    }
+    
+    ids.erase(lower_bound(ids.begin(), ids.end(), last), ids.end());
+}
+
+/* Checks one field of song i against the term of f */
+bool song_database::filter_row(query_filter &f, uint32_t i, string &scratch) const {
+    
+    const query_term &t = *f.term;
+    
+    switch (t.field) {
+        case QUERY_ARTIST:
+        case QUERY_ALBUM:
+        case QUERY_GENRE: {
+            uint32_t id = t.field == QUERY_ARTIST ? artist_ids[i] : t.field == QUERY_ALBUM ? album_ids[i] : genre_ids[i];
+            if (id >= f.names.size()) {
+                f.names.resize(id + 1, -1);
+            }
+            if (f.names[id] < 0) {
+                const string_dictionary &d = t.field == QUERY_ARTIST ? names.artists : t.field == QUERY_ALBUM ? names.albums : names.genres;
+                fold_case(d[id], scratch);
+                f.names[id] = find_bytes(scratch.data(), scratch.size(), t.key_lower) != string_view::npos;
+            }
+            return f.names[id] > 0;
+        }
+        case QUERY_TITLE:
+            if (folded_built && i < folded_titles.size()) {
+                return folded_titles.contains(i, t.key_lower);
+            }
+            fold_case(titles[i], scratch);
+            return find_bytes(scratch.data(), scratch.size(), t.key_lower) != string_view::npos;
+        case QUERY_COMMENTS:
+            fold_case(comments[i], scratch);
+            return find_bytes(scratch.data(), scratch.size(), t.key_lower) != string_view::npos;
+        case QUERY_SIZE:
+            return sizes[i] >= t.low && sizes[i] <= t.high;
+        case QUERY_TIME:
+            return times[i] >= t.low && times[i] <= t.high;
+        case QUERY_YEAR:
+            return years[i] >= t.low && years[i] <= t.high;
+    }
+    
+    return false;
+}
+
+/* Plans every term, then picks how to find songs: from the index that lists
+    the fewest, if listing them costs less than checking every song, or else
+    by checking every song, split between search threads once every song is
+    loaded. Each song is checked against the terms left in order of how much
+    of what is left each is expected to rule out for what it costs, so that
+    cheap, selective terms rule songs out before costly ones are checked.
+    Returns number of songs found.
+ */
+int song_database::display_query(const song_query &q) const{
+    
+    // Songs loaded so far
+    bool loading = is_loading();
+    int ready = loaded_songs();
+    uint32_t last = (uint32_t)ready + 1;
+    
+    vector<query_filter> filters(q.size());
+    for (size_t t=0; t<q.size(); t++) {
+        plan_filter(q[t], filters[t]);
+    }
+    
+    // Checking every song costs at least checking the cheapest term
+    double scan_cost = 0;
+    for (size_t t=0; t<filters.size(); t++) {
+        if (t == 0 || filters[t].cost < scan_cost) {
+            scan_cost = filters[t].cost;
+        }
+    }
+    scan_cost *= ready;
+    
+    // Term whose index lists the fewest songs, if listing them costs less
+    int driver = -1;
+    for (size_t t=0; t<filters.size(); t++) {
+        if (filters[t].indexed && filters[t].index_size * QUERY_INDEX_ROW_COST < scan_cost && (driver < 0 || filters[t].index_size < filters[driver].index_size)) {
+            driver = (int)t;
+        }
+    }
+    
+    // Terms left to check, best first
+    vector<query_filter *> order;
+    for (size_t t=0; t<filters.size(); t++) {
+        if ((int)t != driver || !filters[t].exact) {
+            order.push_back(&filters[t]);
+        }
+    }
+    stable_sort(order.begin(), order.end(), [](const query_filter *a, const query_filter *b) {
+        return (1 - a->selectivity) / a->cost > (1 - b->selectivity) / b->cost;
+    });
+    
+    // Whether song i matches every term left
+    auto matches = [&](uint32_t i, string &scratch) {
+        for (size_t t=0; t<order.size(); t++) {
+            if (!filter_row(*order[t], i, scratch)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    // Song IDs of songs found, in order
+    vector<uint32_t> hits;
+    string scratch;
+    
+    if (driver >= 0) {
+        vector<uint32_t> ids;
+        index_rows(filters[driver], last, ids);
+        for (size_t c=0; c<ids.size(); c++) {
+            if (matches(ids[c], scratch)) {
+                hits.push_back(ids[c]);
+            }
+        }
+    }
+    
+    // Names are compared as they are reached while songs are still loading,
+    // so only one thread may check them
+    else if (loading) {
+        for (uint32_t i=1; i<last; i++) {
+            if (matches(i, scratch)) {
+                hits.push_back(i);
+            }
+        }
+    }
+    
+    else {
+        vector< vector<uint32_t> > part_hits(search_parts(1, last));
+        run_parts(1, last, [&](int part, uint32_t from, uint32_t to) {
+            string part_scratch;
+            for (uint32_t i=from; i<to; i++) {
+                if (matches(i, part_scratch)) {
+                    part_hits[part].push_back(i);
+                }
+            }
+        });
+        join_parts(part_hits, hits);
+    }
+    
+    // Display in console
+    write_songs(hits);
+    report_progress(ready);
+    
+    return (int)hits.size();
+}
+
+/* Reads the page straight out of the field's index, or, without one, checks
+    the field of every song loaded so far and sorts the songs found the way
+    the index would have. Returns number of songs found.
+ */
+int song_database::songs_in_range(query_field field, int low, int high, size_t offset, size_t limit, vector<uint32_t> &ids) const{
+    
+    ids.clear();
+    
+    if (numeric_index_ready()) {
+        size_t first, last;
+        const sorted_index &index = numeric_index(field);
+        index.range(low, high, first, last);
+        
+        size_t from = min(first + offset, last);
+        index.rows(from, from + min(limit, last - from), ids);
+        return (int)(last - first);
+    }
+    
+    const vector<int32_t> &column = field == QUERY_YEAR ? years : field == QUERY_TIME ? times : sizes;
+    
+    // Songs loaded so far
+    uint32_t last = (uint32_t)loaded_songs() + 1;
+    
+    vector< pair<int32_t, uint32_t> > found;
+    for (uint32_t i=1; i<last; i++) {
+        if (column[i] >= low && column[i] <= high) {
+            found.push_back(make_pair(column[i], i));
+        }
+    }
+    
+    size_t from = min(offset, found.size());
+    size_t to = from + min(limit, found.size() - from);
+    partial_sort(found.begin(), found.begin() + to, found.end());
+    for (size_t i=from; i<to; i++) {
+        ids.push_back(found[i].second);
+    }
     
-    return count;
+    return (int)found.size();
 }
@@ -5,11 +5,16 @@
  Description: Definition of Song Database Class (Header File)
 
  Song database of all songs in the program and their song data. Initialized from 
- user supplied file.
+ user supplied file, either read through a file stream or memory-mapped and
+ scanned in place.
 
 - Displays songs with given given song IDs
 - Displays songs containing given key as a substring in song artist.
 - Displays songs containing given key as a substring in the song title.
+- Displays artists and titles closest to a given key, allowing for typos.
+- Completes artists and titles starting with a given prefix.
+- Displays songs matching a query over several song fields at once.
+- Finds songs with a year, time or size in a range, a page at a time.
  
 *****************************************************************************/
 
@@ -21,23 +26,568 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <list>
 #include <algorithm>
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 #include "song.h"
+#include "song_writer.h"
+#include "mapped_file.h"
+#include "row_tokenizer.h"
+#include "string_dictionary.h"
+#include "trigram_index.h"
+#include "folded_column.h"
+#include "fuzzy_index.h"
+#include "prefix_index.h"
+#include "song_query.h"
+#include "sorted_index.h"
+#include "search_cache.h"
 
 using namespace std;
 
 class song_database {
     
-    // Database of songs
-    vector<song> database;
+    // Database of songs, one column per song field. Row n of every column
+    // holds song n; row 0 holds the field headers. Artist, album and genre
+    // repeat from song to song, so their columns hold ids of names kept once
+    // in a dictionary. Time is kept in seconds.
+    vector<string_view> titles;
+    vector<uint32_t> artist_ids;
+    vector<uint32_t> album_ids;
+    vector<uint32_t> genre_ids;
+    vector<int32_t> sizes;
+    vector<int32_t> times;
+    vector<int32_t> years;
+    vector<string_view> comments;
+    
+    // Distinct artists, albums and genres that id columns refer to
+    struct name_dictionaries {
+        string_dictionary artists;
+        string_dictionary albums;
+        string_dictionary genres;
+    };
+    name_dictionaries names;
     
     // Number of songs in database
     int num_of_songs;
-
+    
     // Stream to display songs to console
     ostream &os;
     
+    // Number of rows of database that have been loaded, field headers at
+    // row 0 included. Less than rows() only while a progressive load is still
+    // running in the background. Rows below loaded are complete and never
+    // change again.
+    atomic<int> loaded;
+    
+    // Why a progressive load stopped at an invalid line, as a load_error, or
+    // LOAD_OK if it didn't. Set by the background thread, which then stops,
+    // and reported and cleared by load_failed on the thread running the menu.
+    atomic<int> load_failure;
+    
+    // Background thread of a progressive load, and what waits on it for
+    // songs that have not been loaded yet
+    thread loader;
+    mutable mutex loaded_mutex;
+    mutable condition_variable loaded_cond;
+    
+    // Songs file mapped into memory when loaded in place. Song text fields
+    // point straight into the mapping.
+    mapped_file source;
+    
+    // Text that text columns and dictionaries point into when they can't
+    // point into source: lines read through a file stream, and fields with
+    // double quotes inside them that had to be copied to remove the quotes.
+    // Elements of a list never move, so views into them stay valid as it
+    // grows, and lists filled by separate loader threads can be spliced in
+    // without copying.
+    list<string> text_store;
+    
+    // Reasons a line of the songs file can be rejected
+    enum load_error {
+        LOAD_OK,
+        LOAD_FIELD_COUNT,
+        LOAD_EMPTY_FIELD,
+        LOAD_BAD_HEADER,
+        LOAD_NO_NAME_ARTIST
+    };
+    
+    // Snapshot of the parsed database, kept next to the songs file as
+    // fName.snapshot. When loaded from a snapshot, text columns and
+    // dictionaries point into this mapping instead of source.
+    mapped_file snapshot;
+    
+    // What a snapshot was made from: size, modification time and a hash of
+    // the contents of the songs file. A snapshot is only used if all three
+    // still match the songs file. Device and inode tell a songs file
+    // rewritten in place from one replaced by a new file.
+    struct source_stamp {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash;
+        uint64_t device;
+        uint64_t inode;
+    };
+    
+    // Path & name of songs file, and its stamp when it was last loaded
+    string source_name;
+    source_stamp stamp;
+    
+    // Whether to keep a snapshot of the songs file up to date
+    bool keep_snapshot;
+    
+    // Hash of the line each song was parsed from, so a reload can tell which
+    // lines of the songs file have changed without parsing them
+    vector<uint64_t> line_hash;
+    
+    // Whether searches use trigram indexes, and whether they have been built
+    // for the songs now in the database. Indexes are built by the first
+    // search that runs once every song is loaded.
+    bool search_index;
+    mutable bool search_index_built;
+    
+    // Case folded copies of the title column and of the artist dictionary,
+    // built by the first search that runs once every song is loaded, and
+    // whether they have been built for the songs now in the database
+    mutable bool folded_built;
+    mutable folded_column folded_titles;
+    mutable folded_column folded_artists;
+    
+    // Trigram indexes of the artist dictionary and of the title column, and
+    // the rows of each artist in order, artist_row_first[id] up to
+    // artist_row_first[id+1] in artist_rows
+    mutable trigram_index artist_trigrams;
+    mutable trigram_index title_trigrams;
+    mutable vector<uint32_t> artist_row_first;
+    mutable vector<uint32_t> artist_rows;
+    
+    // Song IDs sorted by year, time and size, and whether they have been
+    // built for the songs now in the database. Built by the first search
+    // that needs them once every song is loaded, if searches use indexes.
+    mutable bool numeric_index_built;
+    mutable sorted_index year_index;
+    mutable sorted_index time_index;
+    mutable sorted_index size_index;
+    
+    // Number of songs with each artist, album and genre in the dictionaries,
+    // and whether they have been counted for the songs now in the database.
+    // Counted by the first search that needs them once every song is loaded.
+    mutable bool name_songs_built;
+    mutable vector<uint32_t> artist_songs;
+    mutable vector<uint32_t> album_songs;
+    mutable vector<uint32_t> genre_songs;
+    
+    // Fuzzy indexes of the folded artist and title columns, and whether they
+    // have been built for the songs now in the database. Built by the first
+    // fuzzy search.
+    mutable bool fuzzy_built;
+    mutable fuzzy_index fuzzy_artists;
+    mutable fuzzy_index fuzzy_titles;
+    
+    // Prefix indexes of the folded artists that have songs and of the folded
+    // titles, and whether they have been built for the songs now in the
+    // database. Built by the first completion.
+    mutable bool prefix_built;
+    mutable prefix_index artist_prefixes;
+    mutable prefix_index title_prefixes;
+    
+    // Number of threads searches are split between
+    int search_threads;
+    
+    // How song listings and search results are written
+    output_format output;
+    
+    // Song IDs found by recent artist and title searches of every song, by
+    // case folded key. Emptied by reload.
+    mutable search_cache search_results;
+    
+    // Most bytes cached search results may use
+    static const size_t SEARCH_CACHE_BYTES = 16 << 20;
+    
+    // A query term as planned: how many songs it is expected to let through,
+    // what checking a song against it costs, and whether an index can list
+    // the songs that may match it instead
+    struct query_filter {
+        const query_term *term;
+        
+        // For artist, album and genre terms, whether key is in each name in
+        // the field's dictionary: 1 if it is, 0 if it isn't, -1 if the name
+        // hasn't been compared yet
+        vector<signed char> names;
+        
+        // Fraction of songs expected to match, and relative cost of checking
+        // one song
+        double selectivity;
+        double cost;
+        
+        // Whether an index can list the songs that may match, about how many
+        // songs it lists, and whether every song it lists matches. Titles
+        // the index finds are kept in candidates.
+        bool indexed;
+        bool exact;
+        size_t index_size;
+        vector<uint32_t> candidates;
+    };
+    
+    // Most characters a fuzzy search lets a match differ from its key by
+    static const int FUZZY_MAX_EDITS = 3;
+    
+    // Fewest rows worth giving a search thread of their own
+    static const uint32_t MIN_SEARCH_PART_ROWS = 1 << 15;
+    
+    // Number of lines a progressive load parses between publishing them
+    static const int LOAD_BATCH = 4096;
+    
+    // Smallest file worth loading in the background. Smaller files load
+    // faster than the menu can be displayed.
+    static const size_t MIN_PROGRESSIVE_BYTES = 1 << 22;
+    
+    // Smallest file worth splitting between loader threads
+    static const size_t MIN_PARALLEL_BYTES = 1 << 20;
+    
+    /* static load_error parse_song(const row_fields &r, int n, song &s,
+            list<string> &store);
+     Validates a single line of the songs file and parses it into song n. 
+     Shared by all load paths so that every path accepts and rejects exactly
+     the same files. Touches no database state, so may be called from several
+     loader threads at once as long as each has its own store.
+        @param      row_fields &r     [in] line, split into fields by a
+                                      row_tokenizer
+        @param      int n             [in] line number of line in file. Line 0
+                                      contains the field headers
+        @param      song &s           [out] song to fill in
+        @param      list<string> &store [in/out] where to keep copies of fields
+                                      that can't point into the line
+        @return     load_error        [out] LOAD_OK if line is valid, else the
+                                      first reason it is invalid
+        @pre        Text r was split from stays valid and unchanged for as long
+                    as s is used.
+        @post       If line contains 8 valid tab delimited fields (and, for line
+                    0, the correct headers), s has song ID n and text fields
+                    that point into the line or into store. Else, s is partly
+                    filled in and must not be used.
+     */
+    static load_error parse_song(const row_fields &r, int n, song &s, list<string> &store);
+    
+    /* size_t rows() const;
+     Returns number of rows in the database, field headers included.
+     */
+    size_t rows() const;
+    
+    /* void resize_rows(size_t n);
+     Resizes every column of the database, and line_hash, to n rows.
+     */
+    void resize_rows(size_t n);
+    
+    /* void set_row(int n, const song &s, name_dictionaries &d);
+     Writes the fields of song s to row n of every column. Artist, album and
+     genre are interned into dictionaries d and their ids written instead.
+        @param      int n             [in] row to write to
+        @param      song &s           [in] song to write, as filled in by
+                                      parse_song
+        @param      name_dictionaries &d [in/out] dictionaries to intern names
+                                      into
+        @pre        n < rows(). Nothing else is writing to row n or to d.
+        @post       Row n holds s. Rows other than n are unchanged, so separate
+                    threads may each write their own rows at once as long as
+                    each has its own d.
+     */
+    void set_row(int n, const song &s, name_dictionaries &d);
+    
+    /* song song_at(int n) const;
+     Returns song in row n, its text fields pointing into the same storage the
+     columns and dictionaries do.
+        @pre        Row n has been loaded.
+     */
+    song song_at(int n) const;
+    
+    /* static void merge_names(string_dictionary &into, const
+            string_dictionary &from, vector<uint32_t> &ids, int first, int
+            last);
+     Interns every name in from into dictionary into, then changes ids in
+     rows first up to last from ids in from to ids in into. Used to merge
+     dictionaries that separate loader threads filled in for their own rows.
+     */
+    static void merge_names(string_dictionary &into, const string_dictionary &from, vector<uint32_t> &ids, int first, int last);
+    
+    /* void add_song(const char *first, const char *last, int n, ostream &err);
+     Splits line n of the songs file, [first, last), into fields, parses it
+     with parse_song and adds it to the end of the database. If line is
+     invalid, program exits with errors written to &err.
+     */
+    void add_song(const char *first, const char *last, int n, ostream &err);
+    
+    /* void load_lines(const char *first, const char *last, int threads,
+            ostream &err);
+     Parses every line in [first, last) into the database, splitting the text
+     at line breaks into one chunk per thread and parsing all chunks at once.
+     Songs are written straight to their final row in database, so song IDs
+     still match line numbers. Each thread interns names into dictionaries of
+     its own, which are merged in file order afterwards, so names get the same
+     ids however many threads there are.
+        @param      const char *first [in] first character of songs file
+        @param      const char *last  [in] one past last character of file
+        @param      int threads       [in] number of threads to parse with
+        @param      ostream &err      [in/out] stream to display errors to
+        @pre        database is empty. threads >= 1.
+        @post       database contains one song per line. If any line is
+                    invalid, program exits with errors written to &err for the
+                    first invalid line in the file, exactly as if the file had
+                    been parsed one line at a time.
+     */
+    void load_lines(const char *first, const char *last, int threads, ostream &err);
+    
+    /* void load_progressive(const char *first, const char *last,
+            const string &snapName, const source_stamp &stamp, ostream &err);
+     Sizes the database to hold every line in [first, last), and the
+     dictionaries to hold a distinct name per line, checks the field headers
+     on the first line, then starts a background thread that parses the rest
+     of the lines in order and publishes them LOAD_BATCH at a time by
+     advancing loaded.
+        @param      const char *first [in] first character of songs file
+        @param      const char *last  [in] one past last character of file
+        @param      string &snapName  [in] snapshot to write once every line
+                                      is loaded. Empty if none is wanted.
+        @param      source_stamp &stamp [in] stamp of songs file
+        @param      ostream &err      [in/out] stream to display errors to
+        @pre        database is empty.
+        @post       database has one row per line and loaded == 1. If the
+                    headers are invalid, program exits with errors written to
+                    &err straight away. If any later line is invalid, program
+                    exits with errors written to &err once the background
+                    thread reaches it.
+     */
+    void load_progressive(const char *first, const char *last, const string &snapName, const source_stamp &stamp, ostream &err);
+    
+    /* void wait_for(int songid) const;
+     Blocks until song songid has been loaded. Returns straight away unless a
+     progressive load is still running.
+     */
+    void wait_for(int songid) const;
+    
+    /* bool folded_columns_ready() const;
+     Returns true if searches can scan the folded columns, building them first
+     if they haven't been built yet. Returns false while a progressive load is
+     still running.
+     */
+    bool folded_columns_ready() const;
+    
+    /* bool search_index_ready() const;
+     Returns true if searches can use the trigram indexes, building them first
+     if they haven't been built yet. Returns false if indexes aren't used, or
+     while a progressive load is still running.
+     */
+    bool search_index_ready() const;
+    
+    /* bool numeric_index_ready() const;
+     Returns true if searches can use the year, time and size indexes,
+     building them first if they haven't been built yet. Returns false if
+     indexes aren't used, or while a progressive load is still running.
+     */
+    bool numeric_index_ready() const;
+    
+    /* const sorted_index & numeric_index(query_field field) const;
+     Returns index of numeric field field.
+        @pre        field is QUERY_YEAR, QUERY_TIME or QUERY_SIZE.
+     */
+    const sorted_index & numeric_index(query_field field) const;
+    
+    /* bool name_songs_ready() const;
+     Returns true if artist_songs, album_songs and genre_songs can be used,
+     counting them first if they haven't been counted yet. Returns false
+     while a progressive load is still running.
+     */
+    bool name_songs_ready() const;
+    
+    /* void fuzzy_index_ready() const;
+     Builds the fuzzy indexes if they haven't been built yet. Waits for a
+     progressive load to finish first, so that every song can be found.
+     */
+    void fuzzy_index_ready() const;
+    
+    /* void prefix_index_ready() const;
+     Builds the prefix indexes if they haven't been built yet. Waits for a
+     progressive load to finish first, so that every song can be found.
+     */
+    void prefix_index_ready() const;
+    
+    /* int search_parts(uint32_t first, uint32_t last) const;
+     Returns number of parts to split rows first up to last into for a
+     search: one per search thread, as long as each part has at least
+     MIN_SEARCH_PART_ROWS rows. Always at least 1.
+     */
+    int search_parts(uint32_t first, uint32_t last) const;
+    
+    /* void run_parts(uint32_t first, uint32_t last, const function<void(int,
+            uint32_t, uint32_t)> &work) const;
+     Splits rows first up to last into search_parts(first, last) parts of
+     nearly equal size, in order, and calls work(part, from, to) for each
+     part on a thread of its own. Returns once every part is done.
+     */
+    void run_parts(uint32_t first, uint32_t last, const function<void(int, uint32_t, uint32_t)> &work) const;
+    
+    /* static void join_parts(vector< vector<uint32_t> > &parts,
+            vector<uint32_t> &ids);
+     Appends song IDs found by each part of a search to ids, in part order.
+     */
+    static void join_parts(vector< vector<uint32_t> > &parts, vector<uint32_t> &ids);
+    
+    /* void plan_filter(const query_term &t, query_filter &f) const;
+     Fills f with what checking songs against t is expected to cost and let
+     through, and whether an index can list the songs matching t.
+     */
+    void plan_filter(const query_term &t, query_filter &f) const;
+    
+    /* void index_rows(const query_filter &f, uint32_t last,
+            vector<uint32_t> &ids) const;
+     Replaces ids with song IDs below last that the index of f lists, in
+     increasing order.
+        @pre        f.indexed is true.
+     */
+    void index_rows(const query_filter &f, uint32_t last, vector<uint32_t> &ids) const;
+    
+    /* bool filter_row(query_filter &f, uint32_t i, string &scratch) const;
+     Returns true if song i matches the term of f. Fields are case folded
+     into scratch when they need to be.
+        @post       Names of f compared for the first time are marked.
+     */
+    bool filter_row(query_filter &f, uint32_t i, string &scratch) const;
+    
+    /* void find_by_artist(const string &key_lower, uint32_t first,
+            uint32_t last, size_t wanted, vector<uint32_t> &hits) const;
+     Appends song IDs of songs from song ID first up to song ID last with
+     key_lower as a substring of their artist to hits, in order, stopping
+     once wanted songs are found.
+        @pre        hits is empty. Songs up to last have been loaded.
+     */
+    void find_by_artist(const string &key_lower, uint32_t first, uint32_t last, size_t wanted, vector<uint32_t> &hits) const;
+    
+    /* void find_by_title(const string &key_lower, uint32_t first,
+            uint32_t last, size_t wanted, vector<uint32_t> &hits) const;
+     Appends song IDs of songs from song ID first up to song ID last with
+     key_lower as a substring of their title to hits, in order, stopping
+     once wanted songs are found.
+        @pre        hits is empty. Songs up to last have been loaded.
+     */
+    void find_by_title(const string &key_lower, uint32_t first, uint32_t last, size_t wanted, vector<uint32_t> &hits) const;
+    
+    /* uint32_t search_block_end(uint32_t from, uint32_t last, size_t wanted)
+            const;
+     Returns one past the last song to scan from song from before checking
+     whether wanted songs have been found: last if wanted is SIZE_MAX, else
+     enough songs to give every search thread a part.
+     */
+    uint32_t search_block_end(uint32_t from, uint32_t last, size_t wanted) const;
+    
+    /* bool search_page(query_field field, const string &key_lower,
+            bool loading, uint32_t last, size_t offset, size_t limit,
+            int after, vector<uint32_t> &page) const;
+     Finds one page of songs below song ID last with key_lower as a
+     substring of field: up to limit songs, skipping the first offset songs
+     after song ID after.
+        @param      query_field field [in] QUERY_ARTIST or QUERY_TITLE
+        @param      bool loading    [in] whether a progressive load was
+                                    running when songs up to last were loaded
+        @param      vector<uint32_t> &page [out] song IDs on page, in order
+        @return     bool            [out] returns true if there are more
+                                    songs after the page. Else, false.
+     */
+    bool search_page(query_field field, const string &key_lower, bool loading, uint32_t last, size_t offset, size_t limit, int after, vector<uint32_t> &page) const;
+    
+    /* void write_songs(const vector<uint32_t> &ids) const;
+     Writes songs with song IDs ids to &os, in the order given, a block at a
+     time. Large results are formatted by the search threads in parts and
+     written part by part, so output is exactly as if written one song at a
+     time.
+        @pre        Every song in ids has been loaded.
+     */
+    void write_songs(const vector<uint32_t> &ids) const;
+    
+    /* void report_progress(int ready) const;
+     If results were taken from only the first ready songs because a 
+     progressive load is still running, writes how many songs that is to &os,
+     so that they aren't mistaken for results from the whole database.
+     */
+    void report_progress(int ready) const;
+    
+    /* bool load_snapshot(const string &snapName, const source_stamp &stamp);
+     Maps snapshot file snapName and fills the database from its columns
+     and dictionaries without parsing any text.
+        @param      string &snapName    [in] path & name of snapshot file
+        @param      source_stamp &stamp [in] stamp of the current songs file
+        @return     bool                [out] returns true if database was
+                                        loaded from the snapshot, else false.
+        @pre        database is empty.
+        @post       If snapName exists, is a well formed snapshot and was made
+                    from a songs file matching stamp, database contains every
+                    song in it with text columns and dictionaries pointing into
+                    snapshot. Else, database and snapshot are left empty.
+     */
+    bool load_snapshot(const string &snapName, const source_stamp &stamp);
+    
+    /* void save_snapshot(const string &snapName, const source_stamp &stamp) const;
+     Writes database to snapshot file snapName as one array per column plus
+     a single blob holding the text of the title and comments columns and
+     of every name in the dictionaries. File is written under a
+     temporary name and renamed into place, so a half written snapshot is
+     never read. Failing to write a snapshot is not an error; the songs file
+     is simply parsed again next time.
+        @param      string &snapName    [in] path & name of snapshot file
+        @param      source_stamp &stamp [in] stamp of songs file database was
+                                        loaded from
+     */
+    void save_snapshot(const string &snapName, const source_stamp &stamp) const;
+    
+    /* string_view snapshot_text(int l, uint32_t i) const;
+     Returns string i of text list l, numbered in the order text lists are
+     kept in a snapshot: titles, comments, artists, albums, genres.
+     */
+    string_view snapshot_text(int l, uint32_t i) const;
+    
+    /* static source_stamp stamp_file(const string &fName, const mapped_file
+            *m);
+     Returns the size, modification time, device and inode of file fName and,
+     if m is not NULL, a hash of the contents of fName mapped by m. Else, hash
+     is 0.
+     */
+    static source_stamp stamp_file(const string &fName, const mapped_file *m);
+    
+    /* static string_view keep_text(string_view s, string &arena);
+     Appends s to arena and returns the copy.
+        @pre        arena has room reserved for s, so it doesn't move.
+     */
+    static string_view keep_text(string_view s, string &arena);
+    
+    /* static uint32_t keep_name(const string_dictionary &from, uint32_t id,
+            string_dictionary &to, vector<uint32_t> &ids, string &arena);
+     Returns the id in to of name id in from, copying the name into arena and
+     adding it to to the first time it is asked for. ids holds the id in to
+     of each name in from already added, else UINT32_MAX.
+     */
+    static uint32_t keep_name(const string_dictionary &from, uint32_t id, string_dictionary &to, vector<uint32_t> &ids, string &arena);
+    
+    /* static void write_load_error(load_error e, ostream &err);
+     Writes the message for load error e to &err.
+     */
+    static void write_load_error(load_error e, ostream &err);
+    
+    /* static void report_load_error(load_error e, ostream &err);
+     Writes the message for load error e to &err and exits with error code -1.
+     */
+    static void report_load_error(load_error e, ostream &err);
+    
+    /* static string_view strip_quotes(string_view field, list<string> &store);
+     Returns a copy of field, kept in store, with all double quotes (") 
+     removed.
+     */
+    static string_view strip_quotes(string_view field, list<string> &store);
+    
 public:
     
 /******************************************************************************
@@ -79,6 +629,118 @@ public:
      */
     song_database(ifstream &readf, string fName = "songs.csv", ostream &o = cout,  ostream &err = cerr);
     
+    /* song_database(const string &fName, int threads = 1, bool use_snapshot =
+        false, bool progressive = false, ostream &o = cout, ostream &err = 
+        cerr);
+     Constructor for song database class that memory-maps file fName and scans
+     it in place instead of reading it line by line through a file stream. Song
+     text fields point into the mapping rather than being copied, so loading 
+     does next to no allocation per song. Large files can be parsed by several
+     threads at once. Checks file for validity exactly as the file stream
+     constructor does.
+        @param      string fName    [in] path & name of file to map
+        @param      int threads     [in] number of threads to parse file with.
+                                    If < 1, uses one thread per core. Files
+                                    smaller than MIN_PARALLEL_BYTES are always
+                                    parsed by a single thread.
+        @param      bool use_snapshot [in] if true, loads from snapshot file
+                                    fName.snapshot when it was made from the
+                                    current contents of fName, skipping parsing
+                                    altogether. Otherwise parses fName and
+                                    writes a new snapshot for next time.
+        @param      bool progressive [in] if true and the file has to be
+                                    parsed and is at least
+                                    MIN_PROGRESSIVE_BYTES long, only checks
+                                    the field headers before returning and
+                                    parses the songs in the background, in
+                                    order, on a single thread. Songs can be
+                                    listed and searched while they load;
+                                    results only cover the songs loaded so
+                                    far.
+        @param      ostream &o      [in/out] stream to display prompt to console
+        @param      ostream &err    [in/out] stream to display errors to console
+        @pre        Same as the file stream constructor. File fName is not
+                    rewritten in place while songs loaded from it are in use.
+                    To change it, replace it with a new file, or reload
+                    straight after rewriting it.
+        @post       Same as the file stream constructor. The file (or its 
+                    snapshot) stays mapped until the database is reloaded.
+     */
+    song_database(const string &fName, int threads = 1, bool use_snapshot = false, bool progressive = false, ostream &o = cout, ostream &err = cerr);
+    
+    /* ~song_database();
+     Destructor for song database class. Waits for a progressive load that is
+     still running to finish.
+     */
+    ~song_database();
+    
+    // Songs point into storage owned by this database, so it can't be copied
+    song_database(const song_database &) = delete;
+    song_database &operator = (const song_database &) = delete;
+    
+    /* bool reload(ostream &err = cerr);
+     Reloads the database from the songs file it was loaded from, parsing only
+     lines that were added or changed since it was last loaded. Every line is
+     still read to find out whether it has changed, but unchanged lines are
+     only hashed, not parsed. Their text is copied out of the mapping of the
+     previous version of the file, which is then unmapped, so a reload never
+     keeps more than one version mapped. If the file was rewritten in place,
+     the previous version is gone from under its mapping, so every line is
+     parsed again. Song IDs still match line numbers, so songs whose lines did
+     not change, or only had lines added after them, keep their song IDs.
+        @param      ostream &err    [in/out] stream to display errors to
+        @return     bool            [out] returns true if database now matches
+                                    the songs file, else returns false.
+        @pre        database was loaded from a songs file. If a progressive load
+                    is running, waits for it to finish first.
+        @post       If songs file is unchanged, nothing is done. If songs file
+                    is valid, songs from changed lines are replaced, songs from
+                    new lines are added, songs past the last line are removed
+                    and the number of each is written to &os. A snapshot is
+                    rewritten if one is kept. If the file can't be read or is
+                    invalid, errors are written to &err and the database is
+                    unchanged.
+     */
+    bool reload(ostream &err = cerr);
+    
+    /* void use_search_index();
+     Makes artist and title searches look keys up in trigram indexes instead
+     of comparing the key to every song. Indexes are built by the first search
+     that runs once every song is loaded, and again after the database is
+     reloaded. Keys shorter than 3 characters still compare every song.
+     Results are exactly the same either way.
+        @post       Searches use indexes from now on.
+     */
+    void use_search_index();
+    
+    /* void use_search_threads(int threads);
+     Splits searches between threads once every song is loaded. Each thread
+     searches its own range of song IDs and keeps what it finds; results are
+     put back together in song ID order before being displayed, so they are
+     exactly the same as from a single thread. Catalogs too small to be worth
+     splitting are still searched on one thread. Until this is called,
+     searches use one thread.
+        @param      int threads     [in] number of threads to search with. If
+                                    < 1, uses one thread per core.
+        @post       Searches use up to threads threads from now on.
+     */
+    void use_search_threads(int threads);
+    
+    /* void use_output_format(output_format f);
+     Makes song listings and search results write songs as f: in columns for
+     people to read, or as tab separated values or JSON Lines, one song per
+     line, for other programs to read. Messages that aren't songs, like the
+     number of songs found, are still written as text.
+        @param      output_format f [in] how to write songs
+        @post       Songs are written as f from now on.
+     */
+    void use_output_format(output_format f);
+    
+    /* output_format get_output_format() const;
+     Returns how song listings and search results write songs.
+     */
+    output_format get_output_format() const;
+    
     /* string lowercase(string word) const;
      Returns an all-lowercase string version of the input string.
         @param      string word     [in] string to convert to lowercase
@@ -96,14 +758,16 @@ public:
  ******************************************************************************/
     
     /* song get_song (int songid) const;
-        Returns a song from the database with song ID songid.
+        Returns a song from the database with song ID songid. Song text
+        fields point into the database; none of them are copied.
             @param      int songid  [in] song id of song to return
             @return     song        [out] instance of song class where 
                                     song.id == songid
             @pre        songid is an intialized, non-empty integer >= 1 && 
                         <= num_of_songs
             @post       database[songid] (song where song.id == songid) is 
-                        returned
+                        returned. If a progressive load hasn't reached songid
+                        yet, waits for it first.
      */
     song get_song(int songid) const;
     
@@ -115,14 +779,45 @@ public:
                     not including headers at database[0]
         @post       returns num_of_songs
      */
-    const int size() const;
+    int size() const;
+    
+    /* int loaded_songs() const;
+     Returns the number of songs that have been loaded so far.
+        @return     int         [out] number of songs that can be listed and
+                                searched right now
+        @pre        database is initialized.
+        @post       Returns num_of_songs once loading has finished. While a
+                    progressive load is running, returns the number of songs
+                    loaded so far, which only ever grows.
+     */
+    int loaded_songs() const;
+    
+    /* bool is_loading() const;
+     Returns true if a progressive load is still running. Else, returns false.
+     */
+    bool is_loading() const;
+    
+    /* bool load_failed(ostream &err);
+     Checks whether a progressive load stopped at an invalid line of the
+     songs file. If it did, drops the songs after it that were never loaded,
+     so the database holds just the songs before it, and writes why to &err.
+        @param      ostream &err    [in/out] stream to write error to
+        @return     bool            [out] returns true if a failed load was
+                                    reported, else returns false. A failed
+                                    load is only reported once.
+        @pre        Called from the thread running the menu, which is the only
+                    thread reading the database.
+        @post       If true is returned, loading has finished and size() is
+                    the number of songs before the invalid line.
+     */
+    bool load_failed(ostream &err);
     
     
 /******************************************************************************
     Displaying songs from the song database
  ******************************************************************************/
     
-    /* const void list_songs(int first, int last) const;
+    /* void list_songs(int first, int last) const;
      Displays songs starting with song where song.id == first to song where 
      song.id == last.
         @param      int     [in] song ID of first song to display
@@ -138,11 +833,30 @@ public:
                     If last > num_of_songs, displays from database[first] to 
                     database[num_of_songs]. If first > last, returns without 
                     displaying anything. Songs delimited by a line break.
+                    While a progressive load is running, only displays songs
+                    loaded so far, followed by how many songs that is.
+     */
+    void list_songs(int first, int last) const;
+    
+    /* int list_songs(int first, int last, size_t offset, size_t limit,
+            int &after) const;
+     Displays one page of the songs list_songs(first, last) would display.
+        @param      int     [in] song ID of first song to display
+        @param      int     [in] song ID of last song to display
+        @param      size_t offset [in] number of songs to skip
+        @param      size_t limit [in] most songs to display
+        @param      int &after  [in/out] cursor: only songs after song ID
+                                after are displayed, 0 for none. Set to the
+                                song ID of the last song displayed if there
+                                are more songs after it, else to 0.
+        @return     int     [out] number of songs displayed
+        @post       Same as list_songs(first, last), but only up to limit
+                    songs, starting offset songs after the cursor.
      */
-    const void list_songs(int first, int last) const;
+    int list_songs(int first, int last, size_t offset, size_t limit, int &after) const;
     
     
-    /* const int display_songs_by_artist(string &key) const;
+    /* int display_songs_by_artist(string &key) const;
      Case insensitive search through database that displays all and any songs
      that have key as a substring of song.artist.
      @param      string &key  [in] string to search for
@@ -151,11 +865,29 @@ public:
                  function exists to write songs to os stream.
      @post       A line delimited list of all songs that contain key in any
                  mixture of cases as all or part of song.artist is written to
-                 &os.
+                 &os. While a progressive load is running, only searches songs
+                 loaded so far, and writes how many songs that is to &os.
+                 Once every song is loaded, results are cached, and a repeat
+                 of a search is answered from the cache.
      */
-    const int display_songs_by_artist(string &key) const;
+    int display_songs_by_artist(string &key) const;
     
-    /* const int display_songs_by_title(string &key) const;
+    /* int display_songs_by_artist(string &key, size_t offset, size_t limit,
+            int &after) const;
+     Displays one page of the songs display_songs_by_artist(key) would display. The
+     search stops as soon as the page and one more song are found.
+     @param     string &key  [in] string to search for
+     @param     size_t offset [in] number of songs found to skip
+     @param     size_t limit [in] most songs to display
+     @param     int &after   [in/out] cursor: only songs after song ID after
+                             are searched, 0 for every song. Set to the song
+                             ID of the last song displayed if more songs
+                             were found after it, else to 0.
+     @return    int          [out] number of songs displayed
+     */
+    int display_songs_by_artist(string &key, size_t offset, size_t limit, int &after) const;
+    
+    /* int display_songs_by_title(string &key) const;
      Case insensitive search through database that displays all and any songs
      that have key as a substring of song.title.
      @param     string &key  [in] string to search for
@@ -164,9 +896,130 @@ public:
                 function exists to write songs to os stream.
      @post      A line delimited list of all songs that contain key in any
                 mixture of cases as all or part of song.title is written to 
-                &os.
+                &os. While a progressive load is running, only searches songs
+                loaded so far, and writes how many songs that is to &os.
+                Once every song is loaded, results are cached, and a repeat
+                of a search is answered from the cache.
+     */
+    int display_songs_by_title(string &key) const;
+    
+    /* int display_songs_by_title(string &key, size_t offset, size_t limit,
+            int &after) const;
+     Displays one page of the songs display_songs_by_title(key) would display. The
+     search stops as soon as the page and one more song are found.
+     @param     string &key  [in] string to search for
+     @param     size_t offset [in] number of songs found to skip
+     @param     size_t limit [in] most songs to display
+     @param     int &after   [in/out] cursor: only songs after song ID after
+                             are searched, 0 for every song. Set to the song
+                             ID of the last song displayed if more songs
+                             were found after it, else to 0.
+     @return    int          [out] number of songs displayed
+     */
+    int display_songs_by_title(string &key, size_t offset, size_t limit, int &after) const;
+    
+    /* int find_songs(query_field field, string &key,
+            vector<uint32_t> &ids) const;
+     Finds every song display_songs_by_artist(key) or
+     display_songs_by_title(key) would display, without displaying them.
+     @param     query_field field [in] QUERY_ARTIST or QUERY_TITLE
+     @param     string &key  [in] string to search for
+     @param     vector<uint32_t> &ids [out] song IDs of songs found, in order
+     @return    int          [out] number of songs found
+     */
+    int find_songs(query_field field, string &key, vector<uint32_t> &ids) const;
+    
+    /* void display_cache_stats() const;
+     Writes how often artist and title searches were answered from the
+     search cache, and how much the cache holds, to &os.
+     */
+    void display_cache_stats() const;
+    
+    /* int display_closest(string &key, int k) const;
+     Case insensitive fuzzy search through database that displays the artists
+     and titles closest to key, even if key is misspelled.
+     @param     string &key  [in] string to search for
+     @param     int k        [in] most artists, and most titles, to display
+     @pre       &key is an initialized, nonempty string. k > 0.
+     @post      Up to k artists, each with how many songs they have, then up
+                to k titles, each with every song that has it, are written to
+                &os. Both are closest first: those with a part needing the
+                fewest characters inserted, deleted or changed to become key.
+                One change is allowed, plus one for every 4 characters of key,
+                up to FUZZY_MAX_EDITS.
+                Waits for a progressive load to finish before searching.
+     @return    int          [out] number of artists and titles displayed
+     */
+    int display_closest(string &key, int k) const;
+    
+    /* void artist_completions(const string &prefix, int n,
+            vector<string_view> &found) const;
+     Finds the first n distinct artists, in alphabetical order ignoring case,
+     starting with prefix in any mixture of cases.
+     @param     const string &prefix [in] what has been typed so far
+     @param     int n        [in] most artists to find
+     @param     vector<string_view> &found [out] artists found, spelled as
+                                   the first artist with songs by that name
+     @post      Only artists with songs are found. Waits for a progressive
+                load to finish before searching.
+     */
+    void artist_completions(const string &prefix, int n, vector<string_view> &found) const;
+    
+    /* void title_completions(const string &prefix, int n,
+            vector<string_view> &found) const;
+     Finds the first n distinct titles, in alphabetical order ignoring case,
+     starting with prefix in any mixture of cases.
+     @param     const string &prefix [in] what has been typed so far
+     @param     int n        [in] most titles to find
+     @param     vector<string_view> &found [out] titles found, spelled as the
+                                   song with the lowest song ID with that
+                                   title
+     @post      Waits for a progressive load to finish before searching.
+     */
+    void title_completions(const string &prefix, int n, vector<string_view> &found) const;
+    
+    /* int display_completions(string &prefix, int n) const;
+     Displays the first n artists and the first n titles starting with prefix.
+     @param     string &prefix [in] what has been typed so far
+     @param     int n        [in] most artists, and most titles, to display
+     @post      Artists, then titles, found by artist_completions and
+                title_completions are written to &os, one per line.
+     @return    int          [out] number of artists and titles displayed
+     */
+    int display_completions(string &prefix, int n) const;
+    
+    /* int display_query(const song_query &q) const;
+     Displays all and any songs that match every term of q.
+     @param     const song_query &q [in] query to match songs against
+     @post      A line delimited list of all songs matching q is written to
+                &os, in song ID order. The term expected to let the fewest
+                songs through that an index can list songs for is used to
+                find songs, if that beats checking every song. Other terms
+                are checked cheapest and most selective first. While a
+                progressive load is running, only searches songs loaded so
+                far, and writes how many songs that is to &os.
+     @return    int          [out] number of songs displayed
+     */
+    int display_query(const song_query &q) const;
+    
+    /* int songs_in_range(query_field field, int low, int high,
+            size_t offset, size_t limit, vector<uint32_t> &ids) const;
+     Finds songs with field from low up to and including high, in order of
+     field, then song ID, and returns one page of them.
+     @param     query_field field [in] QUERY_YEAR, QUERY_TIME (in seconds) or
+                                  QUERY_SIZE
+     @param     int low      [in] lowest value to find
+     @param     int high     [in] highest value to find
+     @param     size_t offset [in] number of songs found to skip
+     @param     size_t limit [in] most songs to return after those skipped
+     @param     vector<uint32_t> &ids [out] song IDs of the page of songs
+     @return    int          [out] number of songs found in all, on every page
+     @post      With indexes, songs are found with two binary searches and
+                the page is read straight out of the index. Without, or while
+                a progressive load is running, every song loaded so far is
+                checked and the songs found are sorted.
      */
-    const int display_songs_by_title(string &key) const;
+    int songs_in_range(query_field field, int low, int high, size_t offset, size_t limit, vector<uint32_t> &ids) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "song_query.h"
+
+#include <cctype>
+#include <climits>
+
+/* Default constructor. A query with no terms. */
+song_query::song_query() {}
+
+/* Compares name against the name of each field, ignoring case. Names and
+    comments may also be written name and comment.
+ */
+bool song_query::parse_field(string_view name, query_field &field) {
+
+    string lower(name);
+    for (size_t i=0; i<lower.size(); i++) {
+        lower[i] = (char)tolower((unsigned char)lower[i]);
+    }
+
+    if (lower == "title" || lower == "name") { field = QUERY_TITLE; }
+    else if (lower == "artist") { field = QUERY_ARTIST; }
+    else if (lower == "album") { field = QUERY_ALBUM; }
+    else if (lower == "genre") { field = QUERY_GENRE; }
+    else if (lower == "size") { field = QUERY_SIZE; }
+    else if (lower == "time") { field = QUERY_TIME; }
+    else if (lower == "year") { field = QUERY_YEAR; }
+    else if (lower == "comments" || lower == "comment") { field = QUERY_COMMENTS; }
+    else { return false; }
+
+    return true;
+}
+
+/* Reads digits into n, refusing anything too big for an int. A time may have
+    a colon, with minutes before it and two digits of seconds after it.
+ */
+bool song_query::parse_number(string_view s, query_field field, int &n) {
+
+    if (field == QUERY_TIME) {
+        size_t colon = s.find(':');
+        if (colon != string_view::npos) {
+            int mins, secs;
+            if (s.size() - colon != 3 || !parse_number(s.substr(0, colon), QUERY_SIZE, mins) || !parse_number(s.substr(colon + 1), QUERY_SIZE, secs) || secs >= 60 || mins > (INT_MAX - secs) / 60) {
+                return false;
+            }
+            n = mins * 60 + secs;
+            return true;
+        }
+    }
+
+    if (s.empty()) {
+        return false;
+    }
+
+    long long value = 0;
+    for (size_t i=0; i<s.size(); i++) {
+        if (!isdigit((unsigned char)s[i])) {
+            return false;
+        }
+        value = value * 10 + (s[i] - '0');
+        if (value > INT_MAX) {
+            return false;
+        }
+    }
+
+    n = (int)value;
+    return true;
+}
+
+/* Reads terms one at a time: a field name, an operator, then a key that runs
+    to the next space or, if it starts with a double quote, to the closing
+    double quote. Stops at the first term that can't be understood.
+ */
+bool song_query::parse(const string &text, ostream &err) {
+
+    terms.clear();
+
+    size_t i = 0;
+    while (true) {
+
+        // Spaces between terms
+        while (i < text.size() && isspace((unsigned char)text[i])) {
+            i++;
+        }
+        if (i == text.size()) {
+            break;
+        }
+
+        // Field name
+        size_t start = i;
+        while (i < text.size() && isalpha((unsigned char)text[i])) {
+            i++;
+        }
+        string_view name(text.data() + start, i - start);
+
+        query_term t;
+        if (!parse_field(name, t.field)) {
+            err << "ERROR: '" << text.substr(start, text.find(' ', start) - start) << "' does not start with a field. Fields are title, artist, album, genre, size, time, year and comments.\n" << endl;
+            return false;
+        }
+
+        // Operator
+        string op;
+        if (i < text.size() && (text[i] == ':' || text[i] == '=' || text[i] == '<' || text[i] == '>')) {
+            op += text[i++];
+            if ((op == "<" || op == ">") && i < text.size() && text[i] == '=') {
+                op += text[i++];
+            }
+        }
+        if (op.empty() || (!is_numeric(t.field) && op != ":" && op != "=")) {
+            err << "ERROR: Field '" << name << "' needs to be followed by " << (is_numeric(t.field) ? ":, =, <, <=, > or >=" : ": or =") << ".\n" << endl;
+            return false;
+        }
+
+        // Key, in double quotes or up to the next space
+        string key;
+        if (i < text.size() && text[i] == '"') {
+            size_t close = text.find('"', i + 1);
+            if (close == string::npos) {
+                err << "ERROR: Missing closing double quote in query.\n" << endl;
+                return false;
+            }
+            key = text.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        else {
+            start = i;
+            while (i < text.size() && !isspace((unsigned char)text[i])) {
+                i++;
+            }
+            key = text.substr(start, i - start);
+        }
+
+        if (key.empty()) {
+            err << "ERROR: Field '" << name << "' has nothing to search for.\n" << endl;
+            return false;
+        }
+
+        // Text fields are searched for key in any case
+        if (!is_numeric(t.field)) {
+            t.key_lower = key;
+            for (size_t c=0; c<t.key_lower.size(); c++) {
+                t.key_lower[c] = (char)tolower((unsigned char)t.key_lower[c]);
+            }
+            t.low = 0;
+            t.high = 0;
+            terms.push_back(t);
+            continue;
+        }
+
+        // Numeric fields are searched for a range
+        t.low = INT_MIN;
+        t.high = INT_MAX;
+        bool ok;
+        size_t dots = key.find("..");
+        if (op == ":" && dots != string::npos) {
+            ok = (dots == 0 || parse_number(string_view(key).substr(0, dots), t.field, t.low)) && (dots + 2 == key.size() || parse_number(string_view(key).substr(dots + 2), t.field, t.high)) && key.size() > 2;
+        }
+        else {
+            int n = 0;
+            ok = parse_number(key, t.field, n);
+            if (op == ":" || op == "=") { t.low = n; t.high = n; }
+            else if (op == "<") { t.high = n - 1; }
+            else if (op == "<=") { t.high = n; }
+            else if (op == ">") { t.low = n == INT_MAX ? n : n + 1; t.high = n == INT_MAX ? n - 1 : t.high; }
+            else { t.low = n; }
+        }
+
+        if (!ok) {
+            err << "ERROR: '" << key << "' is not a " << (t.field == QUERY_TIME ? "time" : "number") << " or range for field '" << name << "'.\n" << endl;
+            return false;
+        }
+
+        terms.push_back(t);
+    }
+
+    return true;
+}
+
+/* Size, time and year are numbers */
+bool song_query::is_numeric(query_field field) {
+    return field == QUERY_SIZE || field == QUERY_TIME || field == QUERY_YEAR;
+}
+
+/* Returns number of terms */
+size_t song_query::size() const { return terms.size(); }
+
+/* Returns terms[i] */
+const query_term & song_query::operator [] (size_t i) const { return terms[i]; }
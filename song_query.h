@@ -0,0 +1,116 @@
+/*****************************************************************************
+ Title:       song_query.h
+ Description: Song Query Class Definition (Header File)
+
+ A query over song fields, parsed from text typed by the user, such as
+     artist:beatles year:1965..1970 genre:rock time<240
+ - A query is a list of terms, and a song matches it if it matches every
+ term.
+ - Title, artist, album, genre and comments terms match songs that have
+ their key as a substring of that field, in any mixture of cases.
+ - Size, time and year terms match songs whose field is in a range, written
+ as field:n, field:first..last (either end may be left out), field=n,
+ field<n, field<=n, field>n or field>=n. Times may be given in seconds or as
+ minutes:seconds.
+ - Keys with spaces in them are put in double quotes.
+
+ *****************************************************************************/
+
+#ifndef ___song_query__
+#define ___song_query__
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Song fields a query can look at
+enum query_field {
+    QUERY_TITLE,
+    QUERY_ARTIST,
+    QUERY_ALBUM,
+    QUERY_GENRE,
+    QUERY_SIZE,
+    QUERY_TIME,
+    QUERY_YEAR,
+    QUERY_COMMENTS
+};
+
+// One term of a query. Text fields use key_lower, numeric fields use the
+// range low up to and including high.
+struct query_term {
+    query_field field;
+    string key_lower;
+    int low;
+    int high;
+};
+
+class song_query {
+
+    // Terms a song has to match, in the order they were typed
+    vector<query_term> terms;
+
+    /* static bool parse_field(string_view name, query_field &field);
+     Finds field called name, ignoring case. Returns false if there is none.
+     */
+    static bool parse_field(string_view name, query_field &field);
+
+    /* static bool parse_number(string_view s, query_field field, int &n);
+     Reads s as a whole number into n, or for time, also as minutes:seconds.
+     Returns false if s is not one.
+     */
+    static bool parse_number(string_view s, query_field field, int &n);
+
+public:
+
+/******************************************************************************
+     Song query constructor
+******************************************************************************/
+
+    /* song_query();
+     Default constructor for song query class.
+        @post       Query has no terms, and matches every song.
+     */
+    song_query();
+
+/******************************************************************************
+     Parsing queries
+******************************************************************************/
+
+    /* bool parse(const string &text, ostream &err);
+     Replaces terms with those in text.
+        @param      const string &text [in] query typed by user
+        @param      ostream &err    [in/out] stream to write errors to
+        @return     bool            [out] returns true if every term in text
+                                    was understood. Else, writes what wasn't
+                                    to &err and returns false.
+        @post       On success, query holds one term per term in text, text
+                    keys in lowercase.
+     */
+    bool parse(const string &text, ostream &err);
+
+/******************************************************************************
+     Returning song query variables / characteristics
+******************************************************************************/
+
+    /* static bool is_numeric(query_field field);
+     Returns true if field is a number rather than text.
+     */
+    static bool is_numeric(query_field field);
+
+    /* size_t size() const;
+     Returns number of terms in query.
+     */
+    size_t size() const;
+
+    /* const query_term & operator [] (size_t i) const;
+     Returns term i of query.
+        @pre        i < size().
+     */
+    const query_term & operator [] (size_t i) const;
+
+};
+
+#endif
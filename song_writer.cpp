@@ -0,0 +1,206 @@
+#include "song_writer.h"
+
+#include <cctype>
+
+/* Constructor. Nothing buffered yet, but room for a block and the song that
+    goes over it.
+ */
+song_writer::song_writer(ostream &o, output_format f): os(o), format_used(f) {
+    buffer.reserve(BLOCK_BYTES + 256);
+}
+
+/* Writes out whatever is left */
+song_writer::~song_writer() {
+    flush();
+}
+
+/* Cuts s to width, as substr(0, width) would, then pads it on the right with
+    spaces, as setw(width) << left would.
+ */
+void song_writer::append_text(string &out, string_view s, size_t width) {
+    if (s.size() > width) {
+        s = s.substr(0, width);
+    }
+    out.append(s.data(), s.size());
+    out.append(width - s.size(), ' ');
+}
+
+/* Writes digits of n back to front into a small buffer on the stack, then
+    pads it on the left with fill, as setw(width) << right would, sign
+    included.
+ */
+void song_writer::append_number(string &out, int n, size_t width, char fill) {
+
+    char digits[12];
+    size_t len = 0;
+
+    unsigned int u = n < 0 ? 0u - (unsigned int)n : (unsigned int)n;
+    do {
+        digits[sizeof(digits) - 1 - len++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (n < 0) {
+        digits[sizeof(digits) - 1 - len++] = '-';
+    }
+
+    if (len < width) {
+        out.append(width - len, fill);
+    }
+    out.append(digits + sizeof(digits) - len, len);
+}
+
+/* Copies runs of characters that need no escaping in one go, escaping the
+    character that ends each run.
+ */
+void song_writer::append_tsv(string &out, string_view s) {
+    size_t from = 0;
+    for (size_t i=0; i<s.size(); i++) {
+        char c = s[i];
+        if (c != '\\' && c != '\t' && c != '\n' && c != '\r') {
+            continue;
+        }
+        out.append(s.data() + from, i - from);
+        out += '\\';
+        out += c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+        from = i + 1;
+    }
+    out.append(s.data() + from, s.size() - from);
+}
+
+/* Copies runs of characters that need no escaping in one go. Control
+    characters without a short escape are written as \u00XX. Other bytes are
+    copied as they are.
+ */
+void song_writer::append_json(string &out, string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    
+    out += '"';
+    size_t from = 0;
+    for (size_t i=0; i<s.size(); i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + from, i - from);
+        out += '\\';
+        switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '\n': out += 'n'; break;
+            case '\t': out += 't'; break;
+            case '\r': out += 'r'; break;
+            case '\b': out += 'b'; break;
+            case '\f': out += 'f'; break;
+            default:
+                out += "u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xf];
+        }
+        from = i + 1;
+    }
+    out.append(s.data() + from, s.size() - from);
+    out += '"';
+}
+
+/* Same fields, widths, alignment and fill as operator << for OUTPUT_TEXT.
+    Every field in full, in the order of the songs file with song ID first,
+    for the others, with time in seconds as the songs file has it.
+ */
+void song_writer::format(const song &s, string &out, output_format f) {
+    
+    if (f == OUTPUT_TSV) {
+        append_number(out, s.id, 0, ' ');
+        out += '\t';
+        append_tsv(out, s.title);
+        out += '\t';
+        append_tsv(out, s.artist);
+        out += '\t';
+        append_tsv(out, s.album);
+        out += '\t';
+        append_tsv(out, s.genre);
+        out += '\t';
+        append_number(out, s.size, 0, ' ');
+        out += '\t';
+        append_number(out, s.time_mins*60 + s.time_secs, 0, ' ');
+        out += '\t';
+        append_number(out, s.year, 0, ' ');
+        out += '\t';
+        append_tsv(out, s.comments);
+        out += '\n';
+        return;
+    }
+    
+    if (f == OUTPUT_JSONL) {
+        out += "{\"id\":";
+        append_number(out, s.id, 0, ' ');
+        out += ",\"title\":";
+        append_json(out, s.title);
+        out += ",\"artist\":";
+        append_json(out, s.artist);
+        out += ",\"album\":";
+        append_json(out, s.album);
+        out += ",\"genre\":";
+        append_json(out, s.genre);
+        out += ",\"size\":";
+        append_number(out, s.size, 0, ' ');
+        out += ",\"time\":";
+        append_number(out, s.time_mins*60 + s.time_secs, 0, ' ');
+        out += ",\"year\":";
+        append_number(out, s.year, 0, ' ');
+        out += ",\"comments\":";
+        append_json(out, s.comments);
+        out += "}\n";
+        return;
+    }
+    
+    append_number(out, s.id, 5, ' ');
+    out += ' ';
+    append_text(out, s.artist, 20);
+    out += ' ';
+    append_text(out, s.title, 30);
+    out += ' ';
+    append_text(out, s.album, 10);
+    out += ' ';
+    append_number(out, s.time_mins, 2, '0');
+    out += ':';
+    append_number(out, s.time_secs, 2, '0');
+    out += ' ';
+    append_number(out, s.year, 4, '0');
+    out += '\n';
+}
+
+/* Formats s onto the end of buffer, reusing the room buffer already has */
+void song_writer::write(const song &s) {
+    format(s, buffer, format_used);
+    if (buffer.size() >= BLOCK_BYTES) {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+/* Writes buffer and empties it */
+void song_writer::flush() {
+    if (!buffer.empty()) {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    os.flush();
+}
+
+/* Compares name against the name of each format, ignoring case. JSON Lines
+    may also be written jsonl.
+ */
+bool song_writer::parse_format(const string &name, output_format &f) {
+    
+    string lower = name;
+    for (size_t i=0; i<lower.size(); i++) {
+        lower[i] = (char)tolower((unsigned char)lower[i]);
+    }
+    
+    if (lower == "text") { f = OUTPUT_TEXT; }
+    else if (lower == "tsv") { f = OUTPUT_TSV; }
+    else if (lower == "json" || lower == "jsonl") { f = OUTPUT_JSONL; }
+    else { return false; }
+    
+    return true;
+}
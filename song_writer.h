@@ -0,0 +1,133 @@
+/*****************************************************************************
+ Title:       song_writer.h
+ Description: Song Writer Class Definition (Header File)
+
+ Writes many songs to a stream, formatted the same way, byte for byte, as
+ writing each with operator << would, or as rows for other programs to read.
+ - Songs are formatted into a buffer the writer keeps, without changing the
+ stream's formatting or making a string for any field.
+ - The buffer is written to the stream a large block at a time, and the
+ stream flushed once when the writer is flushed, not after every song.
+ - Rows for other programs are tab separated values or JSON Lines, with every
+ field of the song. Text is escaped as it is copied into the buffer.
+
+ *****************************************************************************/
+
+#ifndef ___song_writer__
+#define ___song_writer__
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+#include "song.h"
+
+using namespace std;
+
+// How songs are written: in columns for people to read, as one line of tab
+// separated values (id, title, artist, album, genre, size, time in seconds,
+// year and comments) per song, or as one JSON object per line
+enum output_format {
+    OUTPUT_TEXT,
+    OUTPUT_TSV,
+    OUTPUT_JSONL
+};
+
+class song_writer {
+
+    // Stream songs are written to
+    ostream &os;
+
+    // How songs are written
+    output_format format_used;
+    
+    // Songs formatted but not written yet
+    string buffer;
+
+    // Bytes buffered before they are written to the stream
+    static const size_t BLOCK_BYTES = 1 << 16;
+
+    /* static void append_text(string &out, string_view s, size_t width);
+     Appends up to width characters of s to out, then spaces to fill width.
+     */
+    static void append_text(string &out, string_view s, size_t width);
+
+    /* static void append_number(string &out, int n, size_t width,
+            char fill);
+     Appends n to out, with fill in front of it to fill width.
+     */
+    static void append_number(string &out, int n, size_t width, char fill);
+
+    /* static void append_tsv(string &out, string_view s);
+     Appends s to out with backslashes, tabs, line breaks and carriage
+     returns written as \\, \t, \n and \r.
+     */
+    static void append_tsv(string &out, string_view s);
+
+    /* static void append_json(string &out, string_view s);
+     Appends s to out as a JSON string, in double quotes, with double quotes,
+     backslashes and control characters escaped.
+     */
+    static void append_json(string &out, string_view s);
+
+public:
+
+/******************************************************************************
+     Song writer constructor and destructor
+******************************************************************************/
+
+    /* song_writer(ostream &o, output_format f = OUTPUT_TEXT);
+     Constructor for song writer class.
+        @param      ostream &o      [in/out] stream to write songs to
+        @param      output_format f [in] how to write songs
+        @post       Nothing is buffered.
+     */
+    song_writer(ostream &o, output_format f = OUTPUT_TEXT);
+
+    /* ~song_writer();
+     Destructor for song writer class. Flushes songs still buffered.
+     */
+    ~song_writer();
+
+    // Songs buffered by one writer can't be written by another
+    song_writer(const song_writer &) = delete;
+    song_writer &operator = (const song_writer &) = delete;
+
+/******************************************************************************
+     Writing songs
+******************************************************************************/
+
+    /* void write(const song &s);
+     Buffers s, formatted, and writes the buffer to the stream once it holds
+     at least BLOCK_BYTES bytes.
+     */
+    void write(const song &s);
+
+    /* void flush();
+     Writes every song buffered to the stream and flushes the stream.
+     */
+    void flush();
+
+    /* static void format(const song &s, string &out,
+            output_format f = OUTPUT_TEXT);
+     Appends s to out, formatted on one line.
+        @post       For OUTPUT_TEXT, fields are laid out as operator << lays
+                    them out: s.id right aligned in 5 chars, s.artist, s.title
+                    and s.album left aligned in 20, 30 and 10 chars and cut to
+                    fit, then minutes and seconds in 2 digits each and year in
+                    4, with leading 0's. For OUTPUT_TSV, every field in full,
+                    escaped, separated by tabs. For OUTPUT_JSONL, a JSON object
+                    with every field in full. Ends with a line break.
+     */
+    static void format(const song &s, string &out, output_format f = OUTPUT_TEXT);
+
+    /* static bool parse_format(const string &name, output_format &f);
+     Finds output format called name: text, tsv or json, in any case.
+     Returns false if there is none.
+     */
+    static bool parse_format(const string &name, output_format &f);
+
+};
+
+#endif
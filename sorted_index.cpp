@@ -0,0 +1,46 @@
+#include "sorted_index.h"
+
+#include <algorithm>
+#include <utility>
+
+/* Default constructor. Nothing to do until rows are indexed. */
+sorted_index::sorted_index() {}
+
+/* Sorts (value, id) pairs, which puts rows with the same value in id order,
+    then splits them so searches only touch values.
+ */
+void sorted_index::build(const vector<int32_t> &column, uint32_t from, uint32_t to) {
+
+    vector< pair<int32_t, uint32_t> > sorted(to > from ? to - from : 0);
+    for (size_t i=0; i<sorted.size(); i++) {
+        sorted[i] = make_pair(column[from + i], from + (uint32_t)i);
+    }
+    sort(sorted.begin(), sorted.end());
+
+    values.resize(sorted.size());
+    ids.resize(sorted.size());
+    for (size_t i=0; i<sorted.size(); i++) {
+        values[i] = sorted[i].first;
+        ids[i] = sorted[i].second;
+    }
+}
+
+/* First value not below low, and first value above high */
+void sorted_index::range(int32_t low, int32_t high, size_t &first, size_t &last) const {
+
+    if (low > high) {
+        first = last = 0;
+        return;
+    }
+
+    first = lower_bound(values.begin(), values.end(), low) - values.begin();
+    last = upper_bound(values.begin() + first, values.end(), high) - values.begin();
+}
+
+/* Appends ids[first] up to ids[last] */
+void sorted_index::rows(size_t first, size_t last, vector<uint32_t> &out) const {
+    out.insert(out.end(), ids.begin() + first, ids.begin() + last);
+}
+
+/* Returns number of ids */
+size_t sorted_index::size() const { return ids.size(); }
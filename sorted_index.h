@@ -0,0 +1,82 @@
+/*****************************************************************************
+ Title:       sorted_index.h
+ Description: Sorted Index Class Definition (Header File)
+
+ Index of a numeric column sorted by value, for range searches.
+ - Keeps the ids of the indexed rows in order of their value, rows with the
+ same value in order of id, next to a sorted copy of the values.
+ - Rows with values in a range are next to each other, so they are found with
+ two binary searches over the values and read off in order.
+
+ *****************************************************************************/
+
+#ifndef ___sorted_index__
+#define ___sorted_index__
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+class sorted_index {
+
+    // Values of indexed rows, in increasing order, and the id of the row
+    // each came from
+    vector<int32_t> values;
+    vector<uint32_t> ids;
+
+public:
+
+/******************************************************************************
+     Sorted index constructor
+******************************************************************************/
+
+    /* sorted_index();
+     Default constructor for sorted index class.
+        @post       Index is empty.
+     */
+    sorted_index();
+
+/******************************************************************************
+     Building the index
+******************************************************************************/
+
+    /* void build(const vector<int32_t> &column, uint32_t from, uint32_t to);
+     Indexes rows from id from up to id to of column, replacing anything
+     indexed before.
+        @pre        from <= to <= column.size().
+     */
+    void build(const vector<int32_t> &column, uint32_t from, uint32_t to);
+
+/******************************************************************************
+     Searching the index
+******************************************************************************/
+
+    /* void range(int32_t low, int32_t high, size_t &first, size_t &last)
+            const;
+     Finds the positions of rows with values from low up to and including
+     high.
+        @param      int32_t low     [in] lowest value to find
+        @param      int32_t high    [in] highest value to find
+        @param      size_t &first   [out] position of first row found
+        @param      size_t &last    [out] one past position of last row found
+        @post       first == last if no row is in range.
+     */
+    void range(int32_t low, int32_t high, size_t &first, size_t &last) const;
+
+    /* void rows(size_t first, size_t last, vector<uint32_t> &out) const;
+     Appends ids of rows at positions first up to last to out, in order of
+     value, then id.
+        @pre        first <= last <= size().
+     */
+    void rows(size_t first, size_t last, vector<uint32_t> &out) const;
+
+    /* size_t size() const;
+     Returns number of rows indexed.
+     */
+    size_t size() const;
+
+};
+
+#endif
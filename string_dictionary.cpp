@@ -0,0 +1,39 @@
+#include "string_dictionary.h"
+
+/* Default constructor. Nothing to do until strings are added. */
+string_dictionary::string_dictionary() {}
+
+/* Looks s up by its characters. If it isn't found, it is given the next id
+    and added to the end of values.
+ */
+uint32_t string_dictionary::intern(string_view s) {
+
+    uint32_t next = (uint32_t)values.size();
+    pair<unordered_map<string_view, uint32_t>::iterator, bool> found = ids.emplace(s, next);
+
+    // New string
+    if (found.second) {
+        values.push_back(s);
+    }
+
+    return found.first->second;
+}
+
+/* Reserves room in values. Only values is read by other threads, so ids is
+    left to grow as it needs to.
+ */
+void string_dictionary::reserve(size_t n) {
+    values.reserve(n);
+}
+
+/* Empties values and ids */
+void string_dictionary::clear() {
+    values.clear();
+    ids.clear();
+}
+
+/* Returns values[id] */
+string_view string_dictionary::operator [] (uint32_t id) const { return values[id]; }
+
+/* Returns number of distinct strings */
+uint32_t string_dictionary::size() const { return (uint32_t)values.size(); }
@@ -0,0 +1,91 @@
+/*****************************************************************************
+ Title:       string_dictionary.h
+ Description: String Dictionary Class Definition (Header File)
+
+ A dictionary of distinct strings, each numbered by when it was first added.
+ - Interns strings: a string that is already in the dictionary gets back the
+ id it was first given, so a column of ids can stand in for a column of
+ strings that repeat.
+ - Keeps views only. Strings must stay valid for as long as the dictionary
+ is used.
+
+ *****************************************************************************/
+
+#ifndef ___string_dictionary__
+#define ___string_dictionary__
+
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+class string_dictionary {
+
+    // Distinct strings, in the order they were added. Id of a string is its
+    // position.
+    vector<string_view> values;
+
+    // Id of each distinct string
+    unordered_map<string_view, uint32_t> ids;
+
+public:
+
+/******************************************************************************
+     String dictionary constructor
+******************************************************************************/
+
+    /* string_dictionary();
+     Default constructor for string dictionary class.
+        @post       Dictionary is empty.
+     */
+    string_dictionary();
+
+/******************************************************************************
+     Adding strings
+******************************************************************************/
+
+    /* uint32_t intern(string_view s);
+     Returns id of string s, adding it to the dictionary first if it isn't
+     already in it.
+        @param      string_view s   [in] string to look up
+        @return     uint32_t        [out] id of s
+        @pre        Characters s points to stay valid and unchanged for as long
+                    as the dictionary is used.
+        @post       If s was not in the dictionary, it is added with id
+                    size() - 1. Else, dictionary is unchanged.
+     */
+    uint32_t intern(string_view s);
+
+    /* void reserve(size_t n);
+     Makes room for n distinct strings. Until there are more than n, adding a
+     string never moves the ones already in the dictionary, so they can be
+     read by another thread while strings are being added.
+     */
+    void reserve(size_t n);
+
+    /* void clear();
+     Removes every string from the dictionary.
+     */
+    void clear();
+
+/******************************************************************************
+     Returning string dictionary variables / characteristics
+******************************************************************************/
+
+    /* string_view operator [] (uint32_t id) const;
+     Returns string with id id.
+        @pre        id < size().
+     */
+    string_view operator [] (uint32_t id) const;
+
+    /* uint32_t size() const;
+     Returns number of distinct strings in the dictionary.
+     */
+    uint32_t size() const;
+
+};
+
+#endif
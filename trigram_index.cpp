@@ -0,0 +1,106 @@
+#include "trigram_index.h"
+
+#include <cctype>
+#include <algorithm>
+
+/* Returns trigram starting at p, case folded the same way ::tolower folds a
+    character, packed into a key.
+ */
+static uint32_t trigram_at(const char *p) {
+    return (uint32_t)(unsigned char)tolower((unsigned char)p[0]) << 16 | (uint32_t)(unsigned char)tolower((unsigned char)p[1]) << 8 | (uint32_t)(unsigned char)tolower((unsigned char)p[2]);
+}
+
+/* Default constructor. Nothing to do until strings are added. */
+trigram_index::trigram_index(): num_strings(0) {}
+
+/* Appends the new id to the postings of every trigram in s. Ids only ever
+    grow, so postings stay sorted, and a trigram that repeats in s is only
+    listed once by checking the last id in its postings.
+ */
+void trigram_index::add(string_view s) {
+
+    uint32_t id = num_strings++;
+
+    for (size_t i=0; i+3 <= s.size(); i++) {
+        vector<uint32_t> &ids = postings[trigram_at(s.data() + i)];
+        if (ids.empty() || ids.back() != id) {
+            ids.push_back(id);
+        }
+    }
+}
+
+/* Empties postings */
+void trigram_index::clear() {
+    postings.clear();
+    num_strings = 0;
+}
+
+/* Looks up the postings of every trigram in key_lower and intersects them,
+    shortest first so the candidates shrink as fast as they can.
+ */
+bool trigram_index::candidates(string_view key_lower, vector<uint32_t> &ids) const {
+
+    ids.clear();
+
+    // Too short to narrow anything down
+    if (key_lower.size() < 3) {
+        return false;
+    }
+
+    vector<const vector<uint32_t> *> lists;
+    for (size_t i=0; i+3 <= key_lower.size(); i++) {
+
+        // A trigram no string has. Nothing can match.
+        unordered_map<uint32_t, vector<uint32_t> >::const_iterator found = postings.find(trigram_at(key_lower.data() + i));
+        if (found == postings.end()) {
+            return true;
+        }
+        lists.push_back(&found->second);
+    }
+
+    sort(lists.begin(), lists.end(), [](const vector<uint32_t> *a, const vector<uint32_t> *b) { return a->size() < b->size(); });
+
+    ids = *lists[0];
+    vector<uint32_t> both;
+    for (size_t l=1; l<lists.size() && !ids.empty(); l++) {
+
+        // Same trigram twice in key
+        if (lists[l] == lists[l-1]) {
+            continue;
+        }
+
+        both.clear();
+        set_intersection(ids.begin(), ids.end(), lists[l]->begin(), lists[l]->end(), back_inserter(both));
+        ids.swap(both);
+    }
+
+    return true;
+}
+
+/* Adds one to the count of every string in the postings of each distinct
+    trigram of key_lower.
+ */
+size_t trigram_index::count_shared(string_view key_lower, vector<uint16_t> &shared) const {
+
+    vector<uint32_t> keys;
+    for (size_t i=0; i+3 <= key_lower.size(); i++) {
+        keys.push_back(trigram_at(key_lower.data() + i));
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+    for (size_t t=0; t<keys.size(); t++) {
+        unordered_map<uint32_t, vector<uint32_t> >::const_iterator found = postings.find(keys[t]);
+        if (found == postings.end()) {
+            continue;
+        }
+        for (size_t i=0; i<found->second.size(); i++) {
+            shared[found->second[i]]++;
+        }
+    }
+
+    return keys.size();
+}
+
+/* Returns num_strings */
+uint32_t trigram_index::size() const { return num_strings; }
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ Title:       trigram_index.h
+ Description: Trigram Index Class Definition (Header File)
+
+ Inverted index of every three character run (trigram) in a list of strings.
+ - Strings are added in order and numbered from 0. Trigrams are case folded,
+ so the index finds strings regardless of case.
+ - Narrows a case insensitive substring search down to the strings that
+ contain every trigram of the key. Those candidates still have to be checked,
+ since having every trigram of a key doesn't mean containing the key.
+
+ *****************************************************************************/
+
+#ifndef ___trigram_index__
+#define ___trigram_index__
+
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+class trigram_index {
+
+    // Ids of the strings each trigram is in, in increasing order. Trigrams
+    // are packed into the low 24 bits of their key.
+    unordered_map<uint32_t, vector<uint32_t> > postings;
+
+    // Number of strings added
+    uint32_t num_strings;
+
+public:
+
+/******************************************************************************
+     Trigram index constructor
+******************************************************************************/
+
+    /* trigram_index();
+     Default constructor for trigram index class.
+        @post       Index is empty.
+     */
+    trigram_index();
+
+/******************************************************************************
+     Adding strings
+******************************************************************************/
+
+    /* void add(string_view s);
+     Adds s to the index with id size().
+        @param      string_view s   [in] string to add
+        @post       Every trigram of s, case folded, lists id size() - 1.
+     */
+    void add(string_view s);
+
+    /* void clear();
+     Removes every string from the index.
+     */
+    void clear();
+
+/******************************************************************************
+     Searching the index
+******************************************************************************/
+
+    /* bool candidates(string_view key_lower, vector<uint32_t> &ids) const;
+     Finds ids of strings that may contain key_lower.
+        @param      string_view key_lower [in] key to search for, already in
+                                          lowercase
+        @param      vector<uint32_t> &ids [out] ids of strings that contain
+                                          every trigram of key_lower, in
+                                          increasing order
+        @return     bool            [out] returns false if key_lower is too
+                                    short to have any trigrams, in which case
+                                    every string is a candidate and ids is
+                                    left empty. Else, returns true.
+        @post       Every string that contains key_lower, in any mixture of
+                    cases, is in ids.
+     */
+    bool candidates(string_view key_lower, vector<uint32_t> &ids) const;
+
+    /* size_t count_shared(string_view key_lower, vector<uint16_t> &shared)
+            const;
+     Counts, for every string, how many of the distinct trigrams of key_lower
+     it has.
+        @param      string_view key_lower [in] key, already in lowercase
+        @param      vector<uint16_t> &shared [in/out] count for each string id,
+                                          added to. Must have size() elements.
+        @return     size_t          [out] number of distinct trigrams in
+                                    key_lower
+     */
+    size_t count_shared(string_view key_lower, vector<uint16_t> &shared) const;
+
+    /* uint32_t size() const;
+     Returns number of strings added.
+     */
+    uint32_t size() const;
+
+};
+
+#endif